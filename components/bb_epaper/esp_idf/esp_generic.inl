@@ -6,9 +6,15 @@
 #ifndef __ESP_IDF_IO__
 #define __ESP_IDF_IO__
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "esp_timer.h"
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "esp_rom_sys.h"
+#include "esp_attr.h"
 
 #define INPUT 0
 #define INPUT_PULLUP 1
@@ -26,6 +32,50 @@ static spi_bus_config_t buscfg;
 static spi_device_interface_config_t devcfg;
 static spi_transaction_t trans;
 static spi_device_handle_t spi;
+#define MAX_QUEUED_TRANS 8 // SPI driver queue depth
+#ifndef BBEP_NO_SPI_QUEUE
+//
+// Image data is staged into two DMA-capable buffers and queued to the SPI
+// driver; one buffer is transmitted while the next rows are copied into
+// the other. Define BBEP_NO_SPI_QUEUE to fall back to polled transfers.
+//
+#define SPI_STAGE_SIZE 4000
+static uint8_t *pSPIStage[2];
+static spi_transaction_t stage_trans[2];
+static int iStageLen, iStageIdx, iStageQueued;
+static int bDataBurst;
+//
+// Runs of commands from a bbepSendCMDSequence() table are queued as one
+// transaction list with D/C switched by the pre-transfer callback
+//
+#define BBEP_CMD_LIST
+static spi_transaction_t cmd_trans[MAX_QUEUED_TRANS];
+//
+// Whole planes in DMA-capable RAM are queued straight from the frame
+// buffer in large chunks instead of being copied into the staging buffers
+//
+#define BBEP_DMA_WRITE
+#define SPI_DMA_CHUNK 16000 // bytes per direct transaction (multiple rows)
+static spi_transaction_t dma_trans[MAX_QUEUED_TRANS];
+#endif // !BBEP_NO_SPI_QUEUE
+// Large caches (e.g. the glyph cache) go in PSRAM when there is some
+#define BBEP_PSRAM_MALLOC(n) heap_caps_malloc_prefer(n, 2, MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT)
+static uint8_t iSPIDCPin = 0xff;
+// SSD16xx/UC81xx serial timing needs well under 1us of D/C and CS setup
+// before the first clock edge, so a 1us pause leaves plenty of margin
+#define CMD_SETUP_US 1
+//
+// BUSY waits sleep on a level interrupt instead of polling the pin
+//
+#define BBEP_BUSY_IRQ
+static int bBusyIRQ; // ISR is attached to the BUSY pin
+static volatile TaskHandle_t hBusyWaiter; // task to notify when BUSY goes idle
+static portMUX_TYPE busyWaiterMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t hBusyWatchTask; // runs the async refresh callback
+static BBEPDISP *pBusyWatch;
+static volatile int bBusyAsyncPending; // an async refresh hasn't finished yet
+// Same settle time as the polled wait, but slept instead of spun
+#define BUSY_SETTLE_MS 11
 
 #ifdef VSPI_HOST
 #define ESP32_SPI_HOST VSPI_HOST
@@ -34,6 +84,7 @@ static spi_device_handle_t spi;
 #endif // VSPI_HOST
 // foreward references
 void bbepWakeUp(BBEPDISP *pBBEP);
+void bbepWaitBusy(BBEPDISP *pBBEP);
 void bbepSendCMDSequence(BBEPDISP *pBBEP, const uint8_t *pSeq);
 
 void digitalWrite(int iPin, int iState) {
@@ -67,6 +118,11 @@ long millis(void)
     return (long)(esp_timer_get_time() / 1000L);
 } /* millis() */
 
+long micros(void)
+{
+    return (long)esp_timer_get_time();
+} /* micros() */
+
 void delayMicroseconds(long l)
 {
     l *= 40;
@@ -159,10 +215,244 @@ void delayCycles(int i)
         i -= 3;
     }
 }
+#ifndef BBEP_NO_SPI_QUEUE
+//
+// Queue the current staging buffer and switch to the other one
+//
+static void spi_stage_flush(void)
+{
+    spi_transaction_t *t;
+    esp_err_t ret;
+
+    if (iStageLen == 0) return;
+    t = &stage_trans[iStageIdx];
+    memset(t, 0, sizeof(spi_transaction_t));
+    t->length = iStageLen*8; // length in bits
+    t->tx_buffer = pSPIStage[iStageIdx];
+    ret = spi_device_queue_trans(spi, t, portMAX_DELAY);
+    assert(ret==ESP_OK);
+    iStageQueued++;
+    iStageIdx ^= 1;
+    iStageLen = 0;
+    if (iStageQueued == 2) { // the buffer we switched to must finish sending first
+        ret = spi_device_get_trans_result(spi, &t, portMAX_DELAY);
+        assert(ret==ESP_OK);
+        iStageQueued--;
+    }
+} /* spi_stage_flush() */
+//
+// Copy data into the staging buffers, queueing each one as it fills
+// If ucInvert is set, the data is inverted as it's copied
+//
+static void spi_stage_write(uint8_t *pBuf, int iLen, uint8_t ucInvert)
+{
+    while (iLen) {
+        int l = SPI_STAGE_SIZE - iStageLen;
+        uint8_t *d = &pSPIStage[iStageIdx][iStageLen];
+        if (l > iLen) l = iLen;
+        if (ucInvert) {
+            int i = 0;
+            if ((((intptr_t)pBuf | (intptr_t)d) & 3) == 0) { // XOR a word at a time
+                for (; i<l-3; i+=4) {
+                    *(uint32_t *)&d[i] = ~*(uint32_t *)&pBuf[i];
+                }
+            }
+            for (; i<l; i++) {
+                d[i] = ~pBuf[i];
+            }
+        } else {
+            memcpy(d, pBuf, l);
+        }
+        iStageLen += l;
+        pBuf += l;
+        iLen -= l;
+        if (iStageLen == SPI_STAGE_SIZE) {
+            spi_stage_flush();
+        }
+    }
+} /* spi_stage_write() */
+//
+// Wait for queued transactions to finish
+//
+static void spi_queue_drain(int *pQueued)
+{
+    spi_transaction_t *t;
+
+    while (*pQueued) {
+        spi_device_get_trans_result(spi, &t, portMAX_DELAY);
+        (*pQueued)--;
+    }
+} /* spi_queue_drain() */
+//
+// Send a run of data inside a bbepBeginData()/bbepEndData() burst.
+// Data in DMA-capable RAM is queued in place, SPI_DMA_CHUNK bytes per
+// transaction; anything else, or data to be inverted, goes through the
+// staging buffers so one is filled while the other is sent.
+// Returns 0 outside of a burst (the caller sends the data itself).
+//
+int bbepWriteDataDMA(BBEPDISP *pBBEP, uint8_t *pData, int iLen, uint8_t ucInvert)
+{
+    spi_transaction_t *t;
+    int iQueued = 0, iSlot = 0;
+
+    (void)pBBEP;
+    if (!bDataBurst) return 0;
+    if (ucInvert || !esp_ptr_dma_capable(pData) || ((intptr_t)pData & 3)) {
+        spi_stage_write(pData, iLen, ucInvert);
+        return 1;
+    }
+    // keep the data in order behind anything already staged
+    spi_stage_flush();
+    spi_queue_drain(&iStageQueued);
+    while (iLen) {
+        int l = (iLen > SPI_DMA_CHUNK) ? SPI_DMA_CHUNK : iLen;
+        if (iQueued == MAX_QUEUED_TRANS) { // the oldest slot must be done first
+            spi_device_get_trans_result(spi, &t, portMAX_DELAY);
+            iQueued--;
+        }
+        t = &dma_trans[iSlot];
+        memset(t, 0, sizeof(spi_transaction_t));
+        t->length = l*8; // length in bits
+        t->tx_buffer = pData;
+        spi_device_queue_trans(spi, t, portMAX_DELAY);
+        iQueued++;
+        iSlot = (iSlot + 1) % MAX_QUEUED_TRANS;
+        pData += l;
+        iLen -= l;
+    }
+    spi_queue_drain(&iQueued);
+    return 1;
+} /* bbepWriteDataDMA() */
+#endif // !BBEP_NO_SPI_QUEUE
+//
+// Set D/C for a queued transaction; user holds the level + 1 (0 = leave as is)
+//
+static void IRAM_ATTR spi_pre_transfer_callback(spi_transaction_t *t)
+{
+    int iDC = (int)(intptr_t)t->user;
+    if (iDC) {
+        gpio_set_level((gpio_num_t)iSPIDCPin, iDC - 1);
+    }
+} /* spi_pre_transfer_callback() */
+//
+// BUSY reached the idle level; the level interrupt is one-shot
+//
+static void IRAM_ATTR busy_isr_handler(void *arg)
+{
+    BaseType_t bWoken = pdFALSE;
+
+    gpio_intr_disable((gpio_num_t)(intptr_t)arg);
+    if (hBusyWaiter) {
+        vTaskNotifyGiveFromISR(hBusyWaiter, &bWoken);
+    }
+    portYIELD_FROM_ISR(bWoken);
+} /* busy_isr_handler() */
+//
+// Block the calling task until BUSY reads iIdle or iTimeout ms pass.
+// A level interrupt is used so an already idle line returns at once.
+// Like the polled wait, a timeout just gives up.
+// There is one waiter slot; while another task holds it (e.g. the async
+// refresh task) BBEP_ERROR_BUSY is returned and the caller polls instead
+//
+int bbepWaitBusyIRQ(BBEPDISP *pBBEP, int iIdle, int iTimeout)
+{
+    gpio_num_t pin = (gpio_num_t)pBBEP->iBUSYPin;
+
+    if (!bBusyIRQ) return BBEP_ERROR_NOT_SUPPORTED; // caller polls instead
+    portENTER_CRITICAL(&busyWaiterMux);
+    if (hBusyWaiter != NULL) {
+        portEXIT_CRITICAL(&busyWaiterMux);
+        return BBEP_ERROR_BUSY;
+    }
+    hBusyWaiter = xTaskGetCurrentTaskHandle();
+    portEXIT_CRITICAL(&busyWaiterMux);
+    vTaskDelay(pdMS_TO_TICKS(BUSY_SETTLE_MS)); // let the BUSY line become valid
+    ulTaskNotifyTake(pdTRUE, 0); // discard a stale notification
+    gpio_set_intr_type(pin, (iIdle == HIGH) ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+    gpio_intr_enable(pin);
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(iTimeout));
+    gpio_intr_disable(pin);
+    hBusyWaiter = NULL;
+    return BBEP_SUCCESS;
+} /* bbepWaitBusyIRQ() */
+//
+// Waits for each async refresh and calls the app's callback
+//
+static void busy_watch_task(void *arg)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // started by bbepWaitBusyAsync()
+        bbepWaitBusy(pBusyWatch);
+        bBusyAsyncPending = 0; // the callback may start the next refresh
+        if (pBusyWatch->pfnRefreshDone) {
+            (*pBusyWatch->pfnRefreshDone)(pBusyWatch->pRefreshUser);
+        }
+    }
+} /* busy_watch_task() */
+//
+// Return immediately and call pBBEP->pfnRefreshDone when BUSY goes idle
+// Only one async wait can be pending at a time
+//
+int bbepWaitBusyAsync(BBEPDISP *pBBEP)
+{
+    if (bBusyAsyncPending) {
+        return BBEP_ERROR_BUSY;
+    }
+    if (hBusyWatchTask == NULL) {
+        if (xTaskCreate(busy_watch_task, "bbep_busy", 3072, NULL, 5, &hBusyWatchTask) != pdPASS) {
+            hBusyWatchTask = NULL;
+            return BBEP_ERROR_NO_MEMORY;
+        }
+    }
+    pBusyWatch = pBBEP;
+    bBusyAsyncPending = 1;
+    xTaskNotifyGive(hBusyWatchTask);
+    return BBEP_SUCCESS;
+} /* bbepWaitBusyAsync() */
+//
+// True from bbepWaitBusyAsync() until the panel has finished refreshing
+//
+int bbepBusyAsyncPending(void)
+{
+    return bBusyAsyncPending;
+} /* bbepBusyAsyncPending() */
+//
+// Start a run of data writes that are sent as a single CS-asserted burst
+//
+void bbepBeginData(BBEPDISP *pBBEP)
+{
+#ifndef BBEP_NO_SPI_QUEUE
+    if (pSPIStage[1] == NULL || (pBBEP->iFlags & BBEP_CS_EVERY_BYTE)) {
+        return; // use the polled path
+    }
+    digitalWrite(pBBEP->iCSPin, LOW);
+    iStageLen = iStageIdx = iStageQueued = 0;
+    bDataBurst = 1;
+#endif
+} /* bbepBeginData() */
+//
+// Send any staged data, wait for the transfers to finish and release CS
+//
+void bbepEndData(BBEPDISP *pBBEP)
+{
+#ifndef BBEP_NO_SPI_QUEUE
+    if (!bDataBurst) return;
+    spi_stage_flush();
+    spi_queue_drain(&iStageQueued);
+    bDataBurst = 0;
+    digitalWrite(pBBEP->iCSPin, HIGH);
+#endif
+} /* bbepEndData() */
 void spi_write(BBEPDISP *pBBEP, uint8_t *pBuf, int iLen)
 {
     esp_err_t ret;
 
+#ifndef BBEP_NO_SPI_QUEUE
+    if (bDataBurst) { // CS is already low
+        spi_stage_write(pBuf, iLen, 0);
+        return;
+    }
+#endif
     digitalWrite(pBBEP->iCSPin, LOW);
     memset(&trans, 0, sizeof(trans));       //Zero out the transaction
     while (iLen) {
@@ -202,7 +492,7 @@ void bbepWriteCmd(BBEPDISP *pBBEP, uint8_t cmd)
         pBBEP->is_awake = 1;
     }
     digitalWrite(pBBEP->iDCPin, LOW);
-    delay(1);
+    esp_rom_delay_us(CMD_SETUP_US);
     spi_write(pBBEP, &cmd, 1);
     digitalWrite(pBBEP->iDCPin, HIGH); // leave data mode as the default
 } /* bbepWriteCmd() */
@@ -228,6 +518,73 @@ void bbepWriteData(BBEPDISP *pBBEP, uint8_t *pData, int iLen)
         spi_write(pBBEP, pData, iLen);
     }
 } /* bbepWriteData() */
+#ifdef BBEP_CMD_LIST
+//
+// Send the commands of a bbepSendCMDSequence() table up to the next
+// BUSY_WAIT (or the end) with CS held low for the whole run. Each command
+// byte and its parameters become queued transactions, so the CPU doesn't
+// wait on every byte. Returns a pointer to where the run stopped.
+//
+const uint8_t *bbepWriteCmdList(BBEPDISP *pBBEP, const uint8_t *pSeq)
+{
+    spi_transaction_t *t;
+    uint8_t *s = (uint8_t *)pSeq;
+    int iLen, iQueued = 0, iSlot = 0, iOff = 0;
+
+    if (!pBBEP->is_awake) {
+        bbepWakeUp(pBBEP);
+        pBBEP->is_awake = 1;
+    }
+    if (pSPIStage[0] == NULL || (pBBEP->iFlags & BBEP_CS_EVERY_BYTE)) {
+        while (s[0] != 0 && s[0] != BUSY_WAIT) { // one command at a time
+            iLen = *s++;
+            bbepWriteCmd(pBBEP, s[0]);
+            if (iLen > 1) {
+                bbepWriteData(pBBEP, &s[1], iLen-1);
+            }
+            s += iLen;
+        }
+        return s;
+    }
+    digitalWrite(pBBEP->iCSPin, LOW);
+    while (s[0] != 0 && s[0] != BUSY_WAIT) {
+        iLen = *s++;
+        for (int iPart=0; iPart<2; iPart++) { // command byte, then its parameters
+            int l = (iPart == 0) ? 1 : iLen-1;
+            uint8_t *p = (iPart == 0) ? s : &s[1];
+            if (l == 0) break;
+            if (iQueued == MAX_QUEUED_TRANS) { // the oldest slot must be done first
+                spi_device_get_trans_result(spi, &t, portMAX_DELAY);
+                iQueued--;
+            }
+            t = &cmd_trans[iSlot];
+            memset(t, 0, sizeof(spi_transaction_t));
+            t->length = l*8; // length in bits
+            t->user = (void *)(intptr_t)(iPart + 1); // D/C low for the command, high for data
+            if (l <= 4) {
+                t->flags = SPI_TRANS_USE_TXDATA;
+                memcpy(t->tx_data, p, l);
+            } else { // tables may live in flash, copy to DMA memory
+                if (iOff + l > SPI_STAGE_SIZE) {
+                    spi_queue_drain(&iQueued);
+                    iOff = 0;
+                }
+                memcpy(&pSPIStage[0][iOff], p, l);
+                t->tx_buffer = &pSPIStage[0][iOff];
+                iOff += (l + 3) & ~3;
+            }
+            spi_device_queue_trans(spi, t, portMAX_DELAY);
+            iQueued++;
+            iSlot = (iSlot + 1) % MAX_QUEUED_TRANS;
+        }
+        s += iLen;
+    }
+    spi_queue_drain(&iQueued);
+    digitalWrite(pBBEP->iCSPin, HIGH);
+    digitalWrite(pBBEP->iDCPin, HIGH); // leave data mode as the default
+    return s;
+} /* bbepWriteCmdList() */
+#endif // BBEP_CMD_LIST
 
 //
 // Initialize the SPI bus and connections for e-paper displays
@@ -237,6 +594,7 @@ void bbepInitIO(BBEPDISP *pBBEP, uint8_t u8DC, uint8_t u8RST, uint8_t u8BUSY, ui
     esp_err_t ret;
     
     pBBEP->iDCPin = u8DC;
+    iSPIDCPin = u8DC;
     pBBEP->iCSPin = u8CS;
     pBBEP->iMOSIPin = u8MOSI;
     pBBEP->iCLKPin = u8SCK;
@@ -251,6 +609,13 @@ void bbepInitIO(BBEPDISP *pBBEP, uint8_t u8DC, uint8_t u8RST, uint8_t u8BUSY, ui
     delay(100);
     if (pBBEP->iBUSYPin != 0xff) {
         pinMode(pBBEP->iBUSYPin, INPUT);
+        // The service may already be installed by the app (ESP_ERR_INVALID_STATE)
+        ret = gpio_install_isr_service(0);
+        if (ret == ESP_OK || ret == ESP_ERR_INVALID_STATE) {
+            gpio_intr_disable((gpio_num_t)pBBEP->iBUSYPin);
+            bBusyIRQ = (gpio_isr_handler_add((gpio_num_t)pBBEP->iBUSYPin, busy_isr_handler,
+                                             (void *)(intptr_t)pBBEP->iBUSYPin) == ESP_OK);
+        }
     }
     pBBEP->iSpeed = u32Speed;
     pinMode(pBBEP->iCSPin, OUTPUT);
@@ -260,7 +625,11 @@ void bbepInitIO(BBEPDISP *pBBEP, uint8_t u8DC, uint8_t u8RST, uint8_t u8BUSY, ui
     buscfg.miso_io_num = -1; //u8MISO;
     buscfg.mosi_io_num = u8MOSI;
     buscfg.sclk_io_num = u8SCK;
+#ifdef BBEP_DMA_WRITE
+    buscfg.max_transfer_sz = SPI_DMA_CHUNK;
+#else
     buscfg.max_transfer_sz=4096;
+#endif
     buscfg.quadwp_io_num=-1;
     buscfg.quadhd_io_num=-1;
     //Initialize the SPI bus
@@ -271,14 +640,24 @@ void bbepInitIO(BBEPDISP *pBBEP, uint8_t u8DC, uint8_t u8RST, uint8_t u8BUSY, ui
     devcfg.clock_speed_hz = u32Speed;
     devcfg.mode = 0;
     devcfg.spics_io_num = -1; // we control the CS pin
-    devcfg.queue_size = 2;                          //We want to be able to queue 2 transactions at a time
-// These callbacks currently don't do anything
-//    devcfg.pre_cb = spi_pre_transfer_callback;  //Specify pre-transfer callback to handle D/C line
+    devcfg.queue_size = MAX_QUEUED_TRANS;           //Queue up to 8 transactions at a time
+    devcfg.pre_cb = spi_pre_transfer_callback;  //Specify pre-transfer callback to handle D/C line
+// This callback currently doesn't do anything
 //    devcfg.post_cb = spi_post_transfer_callback;
 //    devcfg.flags = SPI_DEVICE_NO_DUMMY; // allow speeds > 26Mhz
     devcfg.flags = SPI_DEVICE_HALFDUPLEX; // this disables SD card access
     ret=spi_bus_add_device(ESP32_SPI_HOST, &devcfg, &spi); // attach to bus
     assert(ret==ESP_OK);
+#ifndef BBEP_NO_SPI_QUEUE
+    if (pSPIStage[0] == NULL) {
+        pSPIStage[0] = (uint8_t *)heap_caps_malloc(SPI_STAGE_SIZE, MALLOC_CAP_DMA);
+        pSPIStage[1] = (uint8_t *)heap_caps_malloc(SPI_STAGE_SIZE, MALLOC_CAP_DMA);
+        if (pSPIStage[1] == NULL) { // not fatal, image data is sent polled
+            heap_caps_free(pSPIStage[0]);
+            pSPIStage[0] = NULL;
+        }
+    }
+#endif
     
     if (pBBEP->iFlags & BBEP_7COLOR) { // need to send before you can send it data
         pBBEP->is_awake = 1;
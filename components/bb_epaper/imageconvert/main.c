@@ -5,90 +5,280 @@
 //
 
 #include <stdio.h>
+#include <ctype.h>
+#include <strings.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 #define MAX_IMAGE_FLIPS 256
 #include "../src/Group5.h"
 #include "../src/g5enc.inl"
+
+//
+// Batch mode packs all of the images into one bundle file:
+// BB_BUNDLE header, BB_BUNDLE_ENTRY index[count], then each image as a
+// BB_BITMAP (header + compressed data) padded with zeros to a multiple
+// of 4 bytes (at least 4 bytes of padding; the decoder reads ahead)
+//
+#define BB_BUNDLE_MARKER 0xBBB5
+#define MAX_NAME_LEN 24
+#define MAX_THREADS 64
+
+typedef struct {
+    uint16_t u16Marker; // 16-bit marker defining a bundle file
+    uint16_t count; // number of images
+    uint32_t size; // total file size
+} BB_BUNDLE;
+
+typedef struct {
+    char szName[MAX_NAME_LEN]; // C identifier, zero terminated
+    uint32_t offset; // BB_BITMAP offset from the start of the bundle
+    uint32_t size; // BB_BITMAP size (header + compressed data)
+} BB_BUNDLE_ENTRY;
+
+// One image of a batch
+typedef struct {
+    char szPath[1024];
+    char szName[MAX_NAME_LEN];
+    uint8_t *pG5; // BB_BITMAP header + compressed data
+    int iG5Size;
+    int w, h, bpp;
+    int iRawSize; // uncompressed 1-bpp size
+    double dTime; // encode time (ms)
+    char szError[128];
+} BATCH_JOB;
+
+typedef struct {
+    BATCH_JOB *pJobs;
+    int iCount;
+    int iNext; // next job to take
+    pthread_mutex_t mutex;
+} BATCH_QUEUE;
+
+static double GetTimeMS(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+} /* GetTimeMS() */
 //
-// Read a Windows BMP file into memory
+// Map a whole file into memory (read only)
+// Returns NULL if it can't be opened or is empty
 //
-uint8_t * ReadBMP(const char *fname, int *width, int *height, int *bpp, unsigned char *pPal)
+static uint8_t *MapFile(const char *fname, int *piSize)
 {
-    int y, w, h, bits, offset;
-    uint8_t *s, *d, *pTemp, *pBitmap;
-    int pitch, bytewidth;
-    int iSize, iDelta;
-    FILE *infile;
-    
-    infile = fopen(fname, "r+b");
-    if (infile == NULL) {
-        printf("Error opening input file %s\n", fname);
+    struct stat st;
+    void *p;
+    int fd;
+
+    fd = open(fname, O_RDONLY);
+    if (fd < 0) return NULL;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
         return NULL;
     }
-    // Read the bitmap into RAM
-    fseek(infile, 0, SEEK_END);
-    iSize = (int)ftell(infile);
-    fseek(infile, 0, SEEK_SET);
-    pBitmap = (uint8_t *)malloc(iSize);
-    pTemp = (uint8_t *)malloc(iSize);
-    fread(pTemp, 1, iSize, infile);
-    fclose(infile);
-    
-    if (pTemp[0] != 'B' || pTemp[1] != 'M' || pTemp[14] < 0x28) {
-        free(pBitmap);
-        free(pTemp);
-        printf("Not a Windows BMP file!\n");
+    p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (p == MAP_FAILED) return NULL;
+    *piSize = (int)st.st_size;
+    return (uint8_t *)p;
+} /* MapFile() */
+//
+// Convert one row of pixels to 1-bpp based on the gray level of each
+// color (1 = white). pPal holds the BMP's palette entries (4 bytes each)
+//
+static void ConvertTo1Bpp(const uint8_t *s, uint8_t *d, int w, int iBpp, const uint8_t *pPal)
+{
+    int g = 0, x, iDelta;
+    const uint8_t *p;
+    uint8_t u8, count;
+
+    iDelta = iBpp/8;
+    count = 8; // bits in a byte
+    u8 = 0; // start with all black
+    for (x=0; x<w; x++) { // slower code, but less code :)
+        u8 <<= 1;
+        switch (iBpp) {
+            case 24:
+            case 32:
+                g = (s[0] + s[1]*2 + s[2])/4; // gray value
+                s += iDelta;
+                break;
+            case 16:
+                g = s[1] & 0xf8; // red
+                g += ((s[0] | s[1] << 8) << 2) & 0x1f0; // green x 2
+                g += (s[0] << 3) & 0xf8; // blue
+                g /= 4;
+                s += 2;
+                break;
+            case 8:
+                p = &pPal[s[0] * 4];
+                g = (p[0] + p[1]*2 + p[2])/4;
+                s++;
+                break;
+            case 4:
+                if (x & 1) {
+                    p = &pPal[(s[0] & 0xf) * 4];
+                    g = (p[0] + p[1]*2 + p[2])/4;
+                    s++;
+                } else {
+                    p = &pPal[(s[0]>>4) * 4];
+                    g = (p[0] + p[1]*2 + p[2])/4;
+                }
+                break;
+        } // switch on bpp
+        if (g >= 128) u8 |= 1; // white
+        count--;
+        if (count == 0) { // byte is full, move on
+            *d++ = u8;
+            u8 = 0;
+            count = 8;
+        }
+    } // for x
+    if (count != 8) { // partial last byte
+        *d = u8 << count;
+    }
+} /* ConvertTo1Bpp() */
+//
+// Read a Windows BMP file held in memory into a 1-bpp bitmap
+// Rows are (w+7)/8 bytes; a few extra bytes follow the last row because
+// the encoder reads past the end of each line
+// Returns NULL (with the reason in szError) if it's not a usable BMP
+//
+static uint8_t *ReadBMP(const uint8_t *pData, int iSize, int *width, int *height, int *bpp, char *szError)
+{
+    int y, w, h, bits, offset, iHeaderSize;
+    const uint8_t *s, *pPal;
+    uint8_t *d, *pBitmap;
+    int pitch, bytewidth, iDestPitch, iDelta;
+
+    if (iSize < 54 || pData[0] != 'B' || pData[1] != 'M' || pData[14] < 0x28) {
+        strcpy(szError, "not a Windows BMP file");
         return NULL;
     }
-    w = *(int32_t *)&pTemp[18];
-    h = *(int32_t *)&pTemp[22];
-    bits = *(int16_t *)&pTemp[26] * *(int16_t *)&pTemp[28];
-    if (bits <= 8 && pPal != NULL) { // it has a palette, copy it
-        uint8_t *p = pPal;
-        for (int i=0; i<(1<<bits); i++)
-        {
-           *p++ = pTemp[54+i*4];
-           *p++ = pTemp[55+i*4];
-           *p++ = pTemp[56+i*4];
-        }
+    iHeaderSize = *(int32_t *)&pData[14];
+    w = *(int32_t *)&pData[18];
+    h = *(int32_t *)&pData[22];
+    bits = *(int16_t *)&pData[26] * *(int16_t *)&pData[28];
+    if (*(int32_t *)&pData[30] != 0 && *(int32_t *)&pData[30] != 3) { // BI_RGB or BI_BITFIELDS only
+        strcpy(szError, "compressed BMP files aren't supported");
+        return NULL;
     }
-    offset = *(int32_t *)&pTemp[10]; // offset to bits
-    if (bits == 1) {
-        bytewidth = (w+7) >> 3;
-    } else {
-        bytewidth = (w * bits) >> 3;
+    if (bits != 1 && bits != 4 && bits != 8 && bits != 16 && bits != 24 && bits != 32) {
+        sprintf(szError, "unsupported bit depth (%d)", bits);
+        return NULL;
     }
+    pPal = &pData[14 + iHeaderSize]; // palette entries are B,G,R,0
+    offset = *(int32_t *)&pData[10]; // offset to bits
+    bytewidth = (w * bits + 7) >> 3;
     pitch = (bytewidth + 3) & 0xfffc; // DWORD aligned
-// move up the pixels
-    d = pBitmap;
-    s = &pTemp[offset];
-    iDelta = pitch;
-    if (h > 0) {
-        iDelta = -pitch;
-        s = &pTemp[offset + (h-1) * pitch];
-    } else {
+    if (h < 0) { // top-down
         h = -h;
+        iDelta = pitch;
+        s = &pData[offset];
+    } else { // bottom-up
+        iDelta = -pitch;
+        s = &pData[offset + (h-1) * pitch];
     }
+    if (w <= 0 || h == 0 || w > 32767 || h > 32767 || offset + (int64_t)pitch * h > iSize) {
+        strcpy(szError, "bad BMP dimensions or truncated file");
+        return NULL;
+    }
+    iDestPitch = (w+7) >> 3;
+    pBitmap = (uint8_t *)malloc(iDestPitch * h + 8);
+    if (pBitmap == NULL) {
+        strcpy(szError, "out of memory");
+        return NULL;
+    }
+    memset(&pBitmap[iDestPitch * h], 0xff, 8);
+    d = pBitmap;
     for (y=0; y<h; y++) {
-        if (bits == 32) {// need to swap red and blue
-            for (int i=0; i<bytewidth; i+=4) {
-                d[i] = s[i+2];
-                d[i+1] = s[i+1];
-                d[i+2] = s[i];
-                d[i+3] = s[i+3];
-            }
-        } else {
-            memcpy(d, s, bytewidth);
+        if (bits == 1) {
+            memcpy(d, s, iDestPitch);
+        } else { // convert to 1-bpp by the gray level of each color
+            ConvertTo1Bpp(s, d, w, bits, pPal);
         }
-        d += bytewidth;
+        d += iDestPitch;
         s += iDelta;
     }
     *width = w;
     *height = h;
     *bpp = bits;
-    free(pTemp);
     return pBitmap;
-    
 } /* ReadBMP() */
+//
+// Compress a 1-bpp bitmap into a BB_BITMAP (header + Group5 data)
+// Returns the size of the allocated *ppOut or 0 for an error
+//
+static int EncodeBitmap(uint8_t *pBitmap, int w, int h, uint8_t **ppOut, char *szError)
+{
+    int rc, y, iPitch, iOutSize, iMaxSize;
+    uint8_t *pOut, *s;
+    G5ENCIMAGE g5enc;
+    BB_BITMAP bbbm;
+
+    iPitch = (w+7) >> 3;
+    // Noisy images can grow; each pixel costs at most 7 bits
+    iMaxSize = sizeof(BB_BITMAP) + w * h + 256;
+    pOut = (uint8_t *)calloc(1, iMaxSize); // zeroed so the output is repeatable
+    if (pOut == NULL) {
+        strcpy(szError, "out of memory");
+        return 0;
+    }
+    rc = g5_encode_init(&g5enc, w, h, &pOut[sizeof(BB_BITMAP)], iMaxSize - sizeof(BB_BITMAP));
+    s = pBitmap;
+    for (y=0; y<h && rc == G5_SUCCESS; y++) {
+        rc = g5_encode_encodeLine(&g5enc, s);
+        s += iPitch;
+    }
+    if (rc != G5_ENCODE_COMPLETE) {
+        if (rc == G5_MAX_FLIPS_EXCEEDED) {
+            sprintf(szError, "more than %d color changes on a line", MAX_IMAGE_FLIPS);
+        } else {
+            sprintf(szError, "error encoding image: %d", rc);
+        }
+        free(pOut);
+        return 0;
+    }
+    iOutSize = g5_encode_getOutSize(&g5enc);
+    if (iOutSize > 0xffff) { // BB_BITMAP has a 16-bit size
+        sprintf(szError, "compressed size %d won't fit in a BB_BITMAP", iOutSize);
+        free(pOut);
+        return 0;
+    }
+    bbbm.u16Marker = BB_BITMAP_MARKER;
+    bbbm.width = w;
+    bbbm.height = h;
+    bbbm.size = iOutSize;
+    memcpy(pOut, &bbbm, sizeof(BB_BITMAP));
+    *ppOut = pOut;
+    return iOutSize + sizeof(BB_BITMAP);
+} /* EncodeBitmap() */
+//
+// Map, decode and compress one BMP file
+// Returns 1 for success, 0 with the reason in szError
+//
+static int ConvertFile(const char *fname, uint8_t **ppOut, int *piOutSize, int *w, int *h, int *bpp, char *szError)
+{
+    uint8_t *pData, *pBitmap;
+    int iSize;
+
+    pData = MapFile(fname, &iSize);
+    if (pData == NULL) {
+        sprintf(szError, "can't open %s", fname);
+        return 0;
+    }
+    pBitmap = ReadBMP(pData, iSize, w, h, bpp, szError);
+    munmap(pData, iSize);
+    if (pBitmap == NULL) return 0;
+    *piOutSize = EncodeBitmap(pBitmap, *w, *h, ppOut, szError);
+    free(pBitmap);
+    return (*piOutSize != 0);
+} /* ConvertFile() */
 
 //
 // Create the comments and const array boilerplate for the hex data bytes
@@ -124,127 +314,345 @@ void AddHexBytes(FILE *f, void *pData, int iLen, int bLast)
         fprintf(f, "};\n");
     }
 } /* AddHexBytes() */
+
 //
-// The user passed a file with the wrong bit depth (not 1)
-// convert to 1-bpp by converting each color to 0 or 1 based on the gray level
+// Make a C identifier from the leaf name of a file, without its extension
 //
-void ConvertTo1Bpp(uint8_t *pBMP, int w, int h, int iBpp, uint8_t *palette)
+static void MakeName(const char *fname, char *szName)
 {
-    int g, x, y, iDelta, iPitch, iDestPitch;
-    uint8_t *s, *d, *pPal, u8, count;
-    
-    iPitch = (w * iBpp)/8;
-    iPitch = (iPitch + 3) & 0xfffc;
-    iDestPitch = (w+7)/8;
-    iDestPitch = (iDestPitch + 3) & 0xfffc; // round to nearest "DWORD"
-    iDelta = iBpp/8;
-    for (y=0; y<h; y++) {
-        s = &pBMP[iPitch * y];
-        d = &pBMP[iDestPitch * y]; // overwrite the original data as we change it
-        count = 8; // bits in a byte
-        u8 = 0; // start with all black
-        for (x=0; x<w; x++) { // slower code, but less code :)
-            u8 <<= 1;
-            switch (iBpp) {
-                case 24:
-                case 32:
-                    g = (s[0] + s[1]*2 + s[2])/4; // gray value
-                    s += iDelta;
-                    break;
-                case 16:
-                    g = s[1] & 0xf8; // red
-                    g += ((s[0] | s[1] << 8) << 2) & 0x1f0; // green x 2
-                    g += (s[0] << 3) & 0xf8; // blue
-                    g /= 4;
-                    s += 2;
-                    break;
-                case 8:
-                    pPal = &palette[s[0] * 4];
-                    g = (pPal[0] + pPal[1]*2 + pPal[2])/4;
-                    s++;
-                    break;
-                case 4:
-                    if (x & 1) {
-                        pPal = &palette[(s[0] & 0xf) * 4];
-                        g = (pPal[0] + pPal[1]*2 + pPal[2])/4;
-                        s++;
-                    } else {
-                        pPal = &palette[(s[0]>>4) * 4];
-                        g = (pPal[0] + pPal[1]*2 + pPal[2])/4;
-                    }
-                    break;
-            } // switch on bpp
-            if (g >= 128) u8 |= 1; // white
-            count--;
-            if (count == 0) { // byte is full, move on
-                *d++ = u8;
-                u8 = 0;
-                count = 8;
+    const char *s = strrchr(fname, '/');
+    int i;
+
+    s = (s) ? s+1 : fname;
+    i = 0;
+    if (isdigit((unsigned char)*s)) szName[i++] = '_';
+    for (; *s && *s != '.' && i < MAX_NAME_LEN-1; s++) {
+        szName[i++] = isalnum((unsigned char)*s) ? *s : '_';
+    }
+    szName[i] = 0;
+} /* MakeName() */
+
+static int HasBMPExtension(const char *fname)
+{
+    int i = strlen(fname);
+    return (i > 4 && strcasecmp(&fname[i-4], ".bmp") == 0);
+} /* HasBMPExtension() */
+
+static int CompareJobs(const void *a, const void *b)
+{
+    return strcmp(((const BATCH_JOB *)a)->szPath, ((const BATCH_JOB *)b)->szPath);
+} /* CompareJobs() */
+
+static BATCH_JOB *AddJob(BATCH_JOB **ppJobs, int *piCount, const char *szPath)
+{
+    BATCH_JOB *pJob;
+
+    if ((*piCount & 63) == 0) {
+        *ppJobs = (BATCH_JOB *)realloc(*ppJobs, (*piCount + 64) * sizeof(BATCH_JOB));
+    }
+    pJob = &(*ppJobs)[(*piCount)++];
+    memset(pJob, 0, sizeof(BATCH_JOB));
+    snprintf(pJob->szPath, sizeof(pJob->szPath), "%s", szPath);
+    MakeName(szPath, pJob->szName);
+    return pJob;
+} /* AddJob() */
+//
+// Collect the images to convert: every .bmp file in a directory (sorted
+// by name) or the files listed in a manifest, one per line, optionally
+// followed by the name to use. Blank lines and lines starting with #
+// are skipped; relative paths are relative to the manifest
+//
+static BATCH_JOB *ReadJobList(const char *szInput, int *piCount)
+{
+    BATCH_JOB *pJobs = NULL;
+    struct stat st;
+    char szPath[1024], szLine[1024], szDir[1024];
+    int iCount = 0;
+
+    *piCount = 0;
+    if (stat(szInput, &st) != 0) {
+        printf("Error opening: %s\n", szInput);
+        return NULL;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        DIR *pDir = opendir(szInput);
+        struct dirent *pEnt;
+        if (pDir == NULL) {
+            printf("Error opening: %s\n", szInput);
+            return NULL;
+        }
+        while ((pEnt = readdir(pDir)) != NULL) {
+            if (!HasBMPExtension(pEnt->d_name)) continue;
+            snprintf(szPath, sizeof(szPath), "%s/%s", szInput, pEnt->d_name);
+            AddJob(&pJobs, &iCount, szPath);
+        }
+        closedir(pDir);
+        if (iCount) qsort(pJobs, iCount, sizeof(BATCH_JOB), CompareJobs);
+    } else { // manifest
+        FILE *f = fopen(szInput, "r");
+        char *s, *szName, *p;
+        if (f == NULL) {
+            printf("Error opening: %s\n", szInput);
+            return NULL;
+        }
+        snprintf(szDir, sizeof(szDir), "%s", szInput);
+        p = strrchr(szDir, '/');
+        if (p) p[1] = 0; else szDir[0] = 0;
+        while (fgets(szLine, sizeof(szLine), f)) {
+            s = szLine;
+            while (isspace((unsigned char)*s)) s++;
+            if (*s == 0 || *s == '#') continue;
+            p = s;
+            while (*p && !isspace((unsigned char)*p)) p++;
+            szName = NULL;
+            if (*p) { // optional name follows the path
+                *p++ = 0;
+                while (isspace((unsigned char)*p)) p++;
+                szName = p;
+                while (*p && !isspace((unsigned char)*p)) p++;
+                *p = 0;
+                if (*szName == 0) szName = NULL;
             }
-        } // for x
-    } // for y
-} /* ConvertTo1Bpp() */
+            if (snprintf(szPath, sizeof(szPath), "%s%s", (*s == '/') ? "" : szDir, s) >= (int)sizeof(szPath)) {
+                printf("Path too long: %s\n", s);
+                continue;
+            }
+            BATCH_JOB *pJob = AddJob(&pJobs, &iCount, szPath);
+            if (szName) MakeName(szName, pJob->szName);
+        }
+        fclose(f);
+    }
+    *piCount = iCount;
+    return pJobs;
+} /* ReadJobList() */
+//
+// Worker thread; converts jobs until the queue is empty
+//
+static void *BatchThread(void *pArg)
+{
+    BATCH_QUEUE *pQueue = (BATCH_QUEUE *)pArg;
+    BATCH_JOB *pJob;
+    double dStart;
+
+    while (1) {
+        pthread_mutex_lock(&pQueue->mutex);
+        pJob = (pQueue->iNext < pQueue->iCount) ? &pQueue->pJobs[pQueue->iNext++] : NULL;
+        pthread_mutex_unlock(&pQueue->mutex);
+        if (pJob == NULL) break;
+        dStart = GetTimeMS();
+        if (ConvertFile(pJob->szPath, &pJob->pG5, &pJob->iG5Size, &pJob->w, &pJob->h, &pJob->bpp, pJob->szError)) {
+            pJob->iRawSize = ((pJob->w + 7) >> 3) * pJob->h;
+        }
+        pJob->dTime = GetTimeMS() - dStart;
+    }
+    return NULL;
+} /* BatchThread() */
+//
+// Write the bundle and a C header describing where each image is in it
+// Returns 0 for success
+//
+static int WriteBundle(const char *szOut, BATCH_JOB *pJobs, int iCount)
+{
+    char szHeader[1024], szPrefix[MAX_NAME_LEN], *p;
+    uint8_t u8Zeros[8] = {0};
+    BB_BUNDLE bundle;
+    BB_BUNDLE_ENTRY *pIndex;
+    uint32_t u32Offset;
+    FILE *f;
+    int i, iPad;
+
+    pIndex = (BB_BUNDLE_ENTRY *)calloc(iCount, sizeof(BB_BUNDLE_ENTRY));
+    u32Offset = sizeof(BB_BUNDLE) + iCount * sizeof(BB_BUNDLE_ENTRY);
+    for (i=0; i<iCount; i++) {
+        strcpy(pIndex[i].szName, pJobs[i].szName);
+        pIndex[i].offset = u32Offset;
+        pIndex[i].size = pJobs[i].iG5Size;
+        u32Offset += (pJobs[i].iG5Size + 4 + 3) & ~3; // zero padding for the decoder
+    }
+    bundle.u16Marker = BB_BUNDLE_MARKER;
+    bundle.count = iCount;
+    bundle.size = u32Offset;
+    f = fopen(szOut, "w+b");
+    if (!f) {
+        printf("Error opening: %s\n", szOut);
+        free(pIndex);
+        return -1;
+    }
+    fwrite(&bundle, 1, sizeof(bundle), f);
+    fwrite(pIndex, sizeof(BB_BUNDLE_ENTRY), iCount, f);
+    for (i=0; i<iCount; i++) {
+        fwrite(pJobs[i].pG5, 1, pJobs[i].iG5Size, f);
+        iPad = ((pJobs[i].iG5Size + 4 + 3) & ~3) - pJobs[i].iG5Size;
+        fwrite(u8Zeros, 1, iPad, f);
+    }
+    fclose(f);
+
+    // C header next to the bundle, same name with .h
+    snprintf(szHeader, sizeof(szHeader), "%s", szOut);
+    p = strrchr(szHeader, '.');
+    if (p && !strchr(p, '/')) *p = 0;
+    MakeName(szHeader, szPrefix);
+    for (p = szPrefix; *p; p++) *p = toupper((unsigned char)*p);
+    strcat(szHeader, ".h");
+    f = fopen(szHeader, "w");
+    if (!f) {
+        printf("Error opening: %s\n", szHeader);
+        free(pIndex);
+        return -1;
+    }
+    fprintf(f, "//\n// Created with imageconvert, written by Larry Bank\n");
+    fprintf(f, "// Asset bundle %s: %d Group5 images, %u bytes\n", szOut, iCount, (unsigned)u32Offset);
+    fprintf(f, "// Layout: 8-byte header (u16 marker 0x%04X, u16 count, u32 size),\n", BB_BUNDLE_MARKER);
+    fprintf(f, "// %d-byte index entries (char name[%d], u32 offset, u32 size),\n", (int)sizeof(BB_BUNDLE_ENTRY), MAX_NAME_LEN);
+    fprintf(f, "// then each BB_BITMAP at its offset\n//\n");
+    fprintf(f, "#ifndef __%s_H__\n#define __%s_H__\n\n", szPrefix, szPrefix);
+    fprintf(f, "#define %s_COUNT %d\n#define %s_SIZE %u\n", szPrefix, iCount, szPrefix, (unsigned)u32Offset);
+    for (i=0; i<iCount; i++) {
+        char szName[MAX_NAME_LEN];
+        strcpy(szName, pJobs[i].szName);
+        for (p = szName; *p; p++) *p = toupper((unsigned char)*p);
+        fprintf(f, "\n// %s: %d x %d\n", pJobs[i].szName, pJobs[i].w, pJobs[i].h);
+        fprintf(f, "#define %s_%s %d\n", szPrefix, szName, i);
+        fprintf(f, "#define %s_%s_OFFSET %u\n", szPrefix, szName, (unsigned)pIndex[i].offset);
+        fprintf(f, "#define %s_%s_SIZE %u\n", szPrefix, szName, (unsigned)pIndex[i].size);
+    }
+    fprintf(f, "\n#endif // __%s_H__\n", szPrefix);
+    fclose(f);
+    free(pIndex);
+    printf("Wrote %s and %s\n", szOut, szHeader);
+    return 0;
+} /* WriteBundle() */
+//
+// Convert a directory or manifest of BMP files into one bundle using
+// a pool of threads, then report each file's compression
+//
+static int BatchConvert(const char *szInput, const char *szOut, int iThreads)
+{
+    pthread_t threads[MAX_THREADS];
+    BATCH_QUEUE queue;
+    BATCH_JOB *pJobs;
+    int i, j, iCount, iErrors = 0;
+    int64_t iRawTotal = 0, iG5Total = 0;
+    double dStart, dCPU = 0.0;
+
+    pJobs = ReadJobList(szInput, &iCount);
+    if (iCount == 0) {
+        printf("No BMP files found in %s\n", szInput);
+        free(pJobs);
+        return -1;
+    }
+    for (i=0; i<iCount; i++) { // names become macros, so they must be unique
+        for (j=0; j<i; j++) {
+            if (strcmp(pJobs[i].szName, pJobs[j].szName) == 0) {
+                printf("Duplicate image name %s (%s and %s)\n", pJobs[i].szName, pJobs[j].szPath, pJobs[i].szPath);
+                free(pJobs);
+                return -1;
+            }
+        }
+    }
+    if (iThreads < 1) iThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (iThreads < 1) iThreads = 1;
+    if (iThreads > MAX_THREADS) iThreads = MAX_THREADS;
+    if (iThreads > iCount) iThreads = iCount;
+    queue.pJobs = pJobs;
+    queue.iCount = iCount;
+    queue.iNext = 0;
+    pthread_mutex_init(&queue.mutex, NULL);
+    dStart = GetTimeMS();
+    for (i=0; i<iThreads; i++) {
+        pthread_create(&threads[i], NULL, BatchThread, &queue);
+    }
+    for (i=0; i<iThreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&queue.mutex);
+
+    printf("%-24s %11s %8s %8s %7s %9s\n", "Image", "Size", "Raw", "G5", "Ratio", "Time(ms)");
+    for (i=0; i<iCount; i++) {
+        BATCH_JOB *pJob = &pJobs[i];
+        if (pJob->pG5 == NULL) {
+            printf("%-24s error: %s\n", pJob->szName, pJob->szError);
+            iErrors++;
+            continue;
+        }
+        printf("%-24s %5d x %-5d %8d %8d %6.1f:1 %9.3f\n", pJob->szName, pJob->w, pJob->h,
+               pJob->iRawSize, pJob->iG5Size, (float)pJob->iRawSize / (float)pJob->iG5Size, pJob->dTime);
+        iRawTotal += pJob->iRawSize;
+        iG5Total += pJob->iG5Size;
+        dCPU += pJob->dTime;
+    }
+    if (iErrors == 0) {
+        printf("%d images, %lld -> %lld bytes (%.1f:1), %.1f ms on %d thread%s (%.1f ms total encode)\n",
+               iCount, (long long)iRawTotal, (long long)iG5Total, (double)iRawTotal / (double)iG5Total,
+               GetTimeMS() - dStart, iThreads, (iThreads == 1) ? "" : "s", dCPU);
+        iErrors = (WriteBundle(szOut, pJobs, iCount) != 0);
+    } else {
+        printf("%d of %d images failed, no bundle written\n", iErrors, iCount);
+    }
+    for (i=0; i<iCount; i++) {
+        free(pJobs[i].pG5);
+    }
+    free(pJobs);
+    return (iErrors) ? -1 : 0;
+} /* BatchConvert() */
 
 int main(int argc, const char * argv[]) {
-    uint8_t *s, *pBMP, *pOut;
-    int rc, w, h, y, bpp;
-    int iOutSize, iPitch;
-    G5ENCIMAGE g5enc;
-    BB_BITMAP bbbm;
-    uint8_t palette[1024];
+    uint8_t *pOut;
+    int w, h, bpp, iOutSize;
+    int iThreads = 0;
+    char szError[128];
     int bHFile; // flag indicating if the output will be a .H file of hex data
 
     printf("Group5 image conversion tool\n");
-    if (argc != 3) {
+    if (argc >= 4 && strcmp(argv[1], "-b") == 0) { // batch mode
+        int i = 2;
+        if (argc == 6 && strcmp(argv[2], "-j") == 0) {
+            iThreads = atoi(argv[3]);
+            i = 4;
+        } else if (argc != 4) {
+            i = 0;
+        }
+        if (i) {
+            return BatchConvert(argv[i], argv[i+1], iThreads);
+        }
+    }
+    if (argc != 3 || argv[1][0] == '-') {
         printf("Usage: ./imgconvert <WinBMP image> <g5 compressed image>\n");
+        printf("       ./imgconvert -b [-j threads] <BMP directory or manifest> <bundle file>\n");
+        printf("Batch mode writes every image into one bundle plus a C header\n");
+        printf("(bundle name with .h) giving each image's offset and size\n");
         return -1;
     }
     pOut = (uint8_t *)argv[2] + strlen(argv[2]) - 1;
     bHFile = (pOut[0] == 'H' || pOut[0] == 'h'); // output an H file?
-    
-    pBMP = ReadBMP(argv[1], &w, &h, &bpp, palette);
-    if (bpp != 1) { // need to convert it to 1-bpp
-        printf("Converting from %d-bpp to 1-bpp\n", bpp);
-        ConvertTo1Bpp(pBMP, w, h, bpp, palette);
+
+    if (!ConvertFile(argv[1], &pOut, &iOutSize, &w, &h, &bpp, szError)) {
+        printf("Error: %s\n", szError);
+        return -1;
     }
-    s = pBMP;
-    printf("Bitmap size: %d x %d\n", w, h);
-    iPitch = (w+7) >> 3;
-    pOut = (uint8_t *)malloc(iPitch * h);
-    rc = g5_encode_init(&g5enc, w, h, pOut, iPitch * h);
-    for (y=0; y<h && rc == G5_SUCCESS; y++) {
-        rc = g5_encode_encodeLine(&g5enc, s);
-        s += iPitch;
+    if (bpp != 1) {
+        printf("Converted from %d-bpp to 1-bpp\n", bpp);
     }
-    if (rc == G5_ENCODE_COMPLETE) {
-        FILE *f;
-        iOutSize = g5_encode_getOutSize(&g5enc);
-        printf("Input data size:  %d bytes, compressed size: %d bytes\n", iPitch*h, iOutSize);
-        printf("Compression ratio: %2.1f:1\n", (float)(iPitch*h) / (float)iOutSize);
-        bbbm.u16Marker = BB_BITMAP_MARKER;
-        bbbm.width = w;
-        bbbm.height = h;
-        bbbm.size = iOutSize;
-        f = fopen(argv[2], "w+b");
-        if (!f) {
-            printf("Error opening: %s\n", argv[2]);
-        } else {
-            if (bHFile) { // generate HEX file to include in a project
-                StartHexFile(f, iOutSize+sizeof(BB_BITMAP), w, h, argv[2]);
-                AddHexBytes(f, &bbbm, sizeof(BB_BITMAP), 0);
-                AddHexBytes(f, pOut, iOutSize, 1);
-                printf(".H file created successfully!\n");
-            } else { // generate a binary file
-                fwrite(&bbbm, 1, sizeof(BB_BITMAP), f);
-                fwrite(pOut, 1, iOutSize, f);
-                printf("Binary file created successfully!\n");
-            }
-            fflush(f);
-            fclose(f);
-        }
+    printf("Bitmap size: %d x %d\n", w, h);
+    iOutSize -= sizeof(BB_BITMAP);
+    printf("Input data size:  %d bytes, compressed size: %d bytes\n", ((w+7)>>3)*h, iOutSize);
+    printf("Compression ratio: %2.1f:1\n", (float)(((w+7)>>3)*h) / (float)iOutSize);
+    FILE *f = fopen(argv[2], "w+b");
+    if (!f) {
+        printf("Error opening: %s\n", argv[2]);
     } else {
-        printf("Error encoding image: %d\n", rc);
+        if (bHFile) { // generate HEX file to include in a project
+            StartHexFile(f, iOutSize+sizeof(BB_BITMAP), w, h, argv[2]);
+            AddHexBytes(f, pOut, sizeof(BB_BITMAP), 0);
+            AddHexBytes(f, &pOut[sizeof(BB_BITMAP)], iOutSize, 1);
+            printf(".H file created successfully!\n");
+        } else { // generate a binary file
+            fwrite(pOut, 1, iOutSize + sizeof(BB_BITMAP), f);
+            printf("Binary file created successfully!\n");
+        }
+        fflush(f);
+        fclose(f);
     }
-    free(pBMP);
+    free(pOut);
     return 0;
 } /* main() */
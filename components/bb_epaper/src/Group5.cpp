@@ -21,11 +21,21 @@ int G5DECODER::init(int iWidth, int iHeight, uint8_t *pData, int iDataSize)
     return g5_decode_init(&_g5dec, iWidth, iHeight, pData, iDataSize);
 } /* init() */
 
+int G5DECODER::initStream(int iWidth, int iHeight, G5_READ_CALLBACK *pfnRead, void *pUser, int iDataSize, uint8_t *pWindow, int iWindowSize)
+{
+    return g5_decode_init_stream(&_g5dec, iWidth, iHeight, pfnRead, pUser, iDataSize, pWindow, iWindowSize);
+} /* initStream() */
+
 int G5DECODER::decodeLine(uint8_t *pOut)
 {
     return g5_decode_line(&_g5dec, pOut);
 } /* decodeLine() */
 
+int G5DECODER::decodeFlips(int16_t **ppFlips)
+{
+    return g5_decode_flips(&_g5dec, ppFlips);
+} /* decodeFlips() */
+
 //
 // Encoder C++ wrapper functions
 //
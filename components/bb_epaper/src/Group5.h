@@ -74,6 +74,16 @@ enum {
     G5_DATA_OVERFLOW,
     G5_MAX_FLIPS_EXCEEDED
 };
+//
+// Callback which supplies streamed G5 data (e.g. from a file)
+// Read up to iLen bytes into pBuf and return the number read
+// A short count (or a negative value) marks the end of the data
+//
+typedef int (G5_READ_CALLBACK)(void *pUser, uint8_t *pBuf, int iLen);
+
+// Smallest window a streaming decoder can work with
+#define G5_MIN_STREAM_BUF 16
+
 //
 // Decoder state
 //
@@ -88,6 +98,11 @@ typedef struct g5_dec_image_tag
     uint32_t u32Accum; // fractional scaling accumulator
     uint32_t ulBitOff, ulBits; // vlc decode variables
     uint8_t *pSrc, *pBuf; // starting & current buffer pointer
+    uint8_t *pBufEnd, *pBufLimit; // end of the data in pSrc & refill point
+    G5_READ_CALLBACK *pfnRead; // streamed data source (NULL = all in memory)
+    void *pUser; // passed to pfnRead
+    int iSrcLeft; // streamed bytes not read yet
+    int iWindowSize; // size of the pSrc window when streaming
     int16_t *pCur, *pRef; // current state of current vs reference flips
     int16_t CurFlips[MAX_IMAGE_FLIPS];
     int16_t RefFlips[MAX_IMAGE_FLIPS];
@@ -101,6 +116,14 @@ inline uint32_t TIFFMOTOLONG(uint8_t *p)
   uint32_t u32 = pgm_read_dword(p);
   return __builtin_bswap32(u32);
 }
+#elif (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__) || defined(__ARM_FEATURE_UNALIGNED)) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+// unaligned loads are allowed here, so read all 4 bytes with one load
+static inline uint32_t TIFFMOTOLONG(const uint8_t *p)
+{
+  uint32_t u32;
+  memcpy(&u32, p, sizeof(u32));
+  return __builtin_bswap32(u32);
+}
 #else
 #define TIFFMOTOLONG(p) (((uint32_t)(*p)<<24UL) + ((uint32_t)(*(p+1))<<16UL) + ((uint32_t)(*(p+2))<<8UL) + (uint32_t)(*(p+3)))
 #endif // __AVR__
@@ -216,7 +239,9 @@ class G5DECODER
 {
   public:
     int init(int iWidth, int iHeight, uint8_t *pData, int iDataSize);
+    int initStream(int iWidth, int iHeight, G5_READ_CALLBACK *pfnRead, void *pUser, int iDataSize, uint8_t *pWindow, int iWindowSize);
     int decodeLine(uint8_t *pOut);
+    int decodeFlips(int16_t **ppFlips);
 
   private:
     G5DECIMAGE _g5dec;
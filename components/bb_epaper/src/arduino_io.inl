@@ -166,6 +166,15 @@ void bbepWriteData(BBEPDISP *pBBEP, uint8_t *pData, int iLen)
 #endif
 } /* bbepWriteData() */
 
+//
+// Data bursts are only batched on ESP-IDF; each write here handles CS itself
+//
+void bbepBeginData(BBEPDISP *pBBEP)
+{
+} /* bbepBeginData() */
+void bbepEndData(BBEPDISP *pBBEP)
+{
+} /* bbepEndData() */
 //
 // Convenience function to write a command byte along with a data
 // byte (it's single parameter)
@@ -29,6 +29,7 @@ int bbepSetPixel4Clr(void *pb, int x, int y, unsigned char ucColor);
 int bbepSetPixel3Clr(void *pb, int x, int y, unsigned char ucColor);
 int bbepSetPixel2Clr(void *pb, int x, int y, unsigned char ucColor);
 int bbepSetPixel16Clr(void *pb, int x, int y, unsigned char ucColor);
+void bbepSelectKernels(BBEPDISP *pBBEP);
 
 // Color mapping tables for each type of display
 // the 7 basic colors (and 9 unsupported) are translated into the correct colors
@@ -2068,6 +2069,7 @@ int bbepSetPanelType(BBEPDISP *pBBEP, int iPanel)
         pBBEP->pfnSetPixel = bbepSetPixel2Clr;
         pBBEP->pfnSetPixelFast = bbepSetPixelFast2Clr;
     }
+    bbepSelectKernels(pBBEP);
     return BBEP_SUCCESS;
 } /* bbepSetPanelType() */
 
@@ -2101,6 +2103,7 @@ int bbepCreateVirtual(BBEPDISP *pBBEP, int iWidth, int iHeight, int iFlags)
             pBBEP->pfnSetPixel = bbepSetPixel2Clr;
             pBBEP->pfnSetPixelFast = bbepSetPixelFast2Clr;
         }
+        bbepSelectKernels(pBBEP);
         return BBEP_SUCCESS;
     } else {
         return BBEP_ERROR_BAD_PARAMETER;
@@ -2126,13 +2129,20 @@ void bbepLightSleep(uint32_t u32Millis)
 void bbepWaitBusy(BBEPDISP *pBBEP)
 {
     int iTimeout = 0;
+    int iMaxTime;
 
     if (!pBBEP) return;
     if (pBBEP->iBUSYPin == 0xff) return;
-    delay(10); // give time for the busy status to be valid
+    iMaxTime = (pBBEP->iTimeout) ? (int)pBBEP->iTimeout : 5000; // B/W updates should never take more than 3 seconds
     uint8_t busy_idle =  (pBBEP->chip_type == BBEP_CHIP_UC81xx) ? HIGH : LOW;
+#ifdef BBEP_BUSY_IRQ
+    if (bbepWaitBusyIRQ(pBBEP, busy_idle, iMaxTime) == BBEP_SUCCESS) {
+        return; // slept through the settle time and until the BUSY line changed
+    }
+#endif
+    delay(10); // give time for the busy status to be valid
     delay(1); // some panels need a short delay before testing the BUSY line
-    while (iTimeout < 5000) { // B/W updates should never take more than 3 seconds
+    while (iTimeout < iMaxTime) {
         if (digitalRead(pBBEP->iBUSYPin) == busy_idle) break;
         // delay(1);
         iTimeout += 200;
@@ -2217,50 +2227,51 @@ void bbepSetAddrWindow(BBEPDISP *pBBEP, int x, int y, int cx, int cy)
         bbepWriteData(pBBEP, uc, i);
         //       EPDWriteCmd(UC8151_PTOU); // partial out
     } else { // SSD16xx
+        // Build the window as a command sequence so it's sent as one burst
+        uint8_t u8Seq[24], *d = u8Seq;
         //        bbepCMD2(pBBEP, SSD1608_DATA_MODE, 0x3);
-        bbepWriteCmd(pBBEP, SSD1608_SET_RAMXPOS);
         tx += pBBEP->x_offset;
         if (pBBEP->type == EP7_960x640 || pBBEP->type == EP426_800x480 || pBBEP->type == EP426_800x480_4GRAY) { // pixels, not bytes version
             if (pBBEP->type == EP7_960x640) {
                 tx <<= 3;
             }
-            uc[0] = (tx & 0xff);
-            uc[1] = ((tx >> 8) & 0xff); // high byte
-            uc[2] = (tx+cx-1) & 0xff; // low byte
-            uc[3] = (tx+cx-1) >> 8; // high byte
-            bbepWriteData(pBBEP, uc, 4);
+            *d++ = 5; *d++ = SSD1608_SET_RAMXPOS;
+            *d++ = (tx & 0xff);
+            *d++ = ((tx >> 8) & 0xff); // high byte
+            *d++ = (tx+cx-1) & 0xff; // low byte
+            *d++ = (tx+cx-1) >> 8; // high byte
             // set ram counter to start of this region
-            bbepWriteCmd(pBBEP, SSD1608_SET_RAMXCOUNT);
-            uc[0] = (tx & 0xff);
-            uc[1] = (tx >> 8);
-            bbepWriteData(pBBEP, uc, 2);
+            *d++ = 3; *d++ = SSD1608_SET_RAMXCOUNT;
+            *d++ = (tx & 0xff);
+            *d++ = (tx >> 8);
         } else { // bytes version
-            uc[0] = tx; // start x (byte boundary)
-            uc[1] = tx+((cx-1)>>3); // end x
-            bbepWriteData(pBBEP, uc, 2);
+            *d++ = 3; *d++ = SSD1608_SET_RAMXPOS;
+            *d++ = tx; // start x (byte boundary)
+            *d++ = tx+((cx-1)>>3); // end x
             // set ram counter to start of this region
-            bbepCMD2(pBBEP, SSD1608_SET_RAMXCOUNT, tx);
+            *d++ = 2; *d++ = SSD1608_SET_RAMXCOUNT;
+            *d++ = tx;
         }
         
-        bbepWriteCmd(pBBEP, SSD1608_SET_RAMYPOS);
+        *d++ = 5; *d++ = SSD1608_SET_RAMYPOS;
         if (pBBEP->type == EP426_800x480 || pBBEP->type == EP426_800x480_4GRAY) { // flipped y
-            uc[2] = (uint8_t)ty; // start y
-            uc[3] = (uint8_t)(ty>>8);
-            uc[0] = (uint8_t)(ty+cy-1); // end y
-            uc[1] = (uint8_t)((ty+cy-1)>>8);
+            *d++ = (uint8_t)(ty+cy-1); // end y
+            *d++ = (uint8_t)((ty+cy-1)>>8);
+            *d++ = (uint8_t)ty; // start y
+            *d++ = (uint8_t)(ty>>8);
         } else {
-            uc[0] = (uint8_t)ty; // start y
-            uc[1] = (uint8_t)(ty>>8);
-            uc[2] = (uint8_t)(ty+cy-1); // end y
-            uc[3] = (uint8_t)((ty+cy-1)>>8);
+            *d++ = (uint8_t)ty; // start y
+            *d++ = (uint8_t)(ty>>8);
+            *d++ = (uint8_t)(ty+cy-1); // end y
+            *d++ = (uint8_t)((ty+cy-1)>>8);
         }
-        bbepWriteData(pBBEP, uc, 4);
         
         // set ram counter to start of this region
-        uc[0] = ty;
-        uc[1] = (ty>>8);
-        bbepWriteCmd(pBBEP, SSD1608_SET_RAMYCOUNT);
-        bbepWriteData(pBBEP, uc, 2);
+        *d++ = 3; *d++ = SSD1608_SET_RAMYCOUNT;
+        *d++ = (uint8_t)ty;
+        *d++ = (uint8_t)(ty>>8);
+        *d++ = 0; // end of table
+        bbepSendCMDSequence(pBBEP, u8Seq);
         //        bbepCMD2(pBBEP, SSD1608_DATA_MODE, 0x3);
     }
     bbepWaitBusy(pBBEP);
@@ -2331,9 +2342,17 @@ void bbepSendCMDSequence(BBEPDISP *pBBEP, const uint8_t *pSeq)
     
     s = (uint8_t *)pSeq;
     while (s[0] != 0) { // A 0 length terminates the list
+#ifdef BBEP_CMD_LIST
+        if (s[0] != BUSY_WAIT) { // send everything up to the next BUSY_WAIT at once
+            s = (uint8_t *)bbepWriteCmdList(pBBEP, s);
+            continue;
+        }
+#endif
         iLen = *s++;
         if (iLen == BUSY_WAIT) {
+            long l = micros();
             bbepWaitBusy(pBBEP);
+            pBBEP->iBusyTime += (int)(micros() - l);
         } else {
             bbepWriteCmd(pBBEP, s[0]);
             s++;
@@ -2362,6 +2381,44 @@ int bbepTestPanelType(BBEPDISP *pBBEP)
         return BBEP_CHIP_SSD16xx; // low state = Solomon ready
 } /* bbepTestPanelType() */
 //
+// Grow the dirty rectangle to include the given area
+// Coordinates are inclusive and in the current (rotated) drawing space
+//
+void bbepMarkDirty(BBEPDISP *pBBEP, int x1, int y1, int x2, int y2)
+{
+    int tmp;
+
+    if (pBBEP == NULL) return;
+    if (x2 < x1) {
+        tmp = x1; x1 = x2; x2 = tmp;
+    }
+    if (y2 < y1) {
+        tmp = y1; y1 = y2; y2 = tmp;
+    }
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 >= pBBEP->width) x2 = pBBEP->width-1;
+    if (y2 >= pBBEP->height) y2 = pBBEP->height-1;
+    if (x1 > x2 || y1 > y2) return; // entirely off the display
+    if (pBBEP->iDirtyX1 > pBBEP->iDirtyX2) { // clean, start a new rectangle
+        pBBEP->iDirtyX1 = x1; pBBEP->iDirtyY1 = y1;
+        pBBEP->iDirtyX2 = x2; pBBEP->iDirtyY2 = y2;
+        return;
+    }
+    if (x1 < pBBEP->iDirtyX1) pBBEP->iDirtyX1 = x1;
+    if (y1 < pBBEP->iDirtyY1) pBBEP->iDirtyY1 = y1;
+    if (x2 > pBBEP->iDirtyX2) pBBEP->iDirtyX2 = x2;
+    if (y2 > pBBEP->iDirtyY2) pBBEP->iDirtyY2 = y2;
+} /* bbepMarkDirty() */
+//
+// Mark the framebuffer as matching the EPD's memory
+//
+void bbepClearDirty(BBEPDISP *pBBEP)
+{
+    pBBEP->iDirtyX1 = pBBEP->iDirtyY1 = 0;
+    pBBEP->iDirtyX2 = pBBEP->iDirtyY2 = -1;
+} /* bbepClearDirty() */
+//
 // Fill the display with a color
 // e.g. all black (0x00) or all white (0xff)
 // if there is no backing buffer, write directly to
@@ -2407,6 +2464,7 @@ void bbepFill(BBEPDISP *pBBEP, unsigned char ucColor, int iPlane)
         }
     }
     if (pBBEP->ucScreen) { // there's a local framebuffer, use it
+        bbepMarkDirty(pBBEP, 0, 0, pBBEP->width-1, pBBEP->height-1);
         if (pBBEP->iFlags & BBEP_7COLOR) {
             memset(pBBEP->ucScreen, uc1, iSize);
             return;
@@ -2530,8 +2588,9 @@ int bbepRefresh(BBEPDISP *pBBEP, int iMode)
         if (iMode == REFRESH_PARTIAL && pBBEP->iFlags & BBEP_PARTIAL2) {
             iMode = REFRESH_PARTIAL2; // special case for custom LUT
         }
-        bbepCMD2(pBBEP, SSD1608_DISP_CTRL2, u8CMD[iMode]);
-        bbepWriteCmd(pBBEP, SSD1608_MASTER_ACTIVATE); // refresh
+        uint8_t u8Seq[6] = {2, SSD1608_DISP_CTRL2, u8CMD[iMode],
+                            1, SSD1608_MASTER_ACTIVATE, 0}; // refresh
+        bbepSendCMDSequence(pBBEP, u8Seq);
     }
     return BBEP_SUCCESS;
 } /* bbepRefresh() */
@@ -2560,6 +2619,7 @@ void bbepSetRotation(BBEPDISP *pBBEP, int iRotation)
             pBBEP->height = pBBEP->native_width;
             break;
     }
+    bbepMarkDirty(pBBEP, 0, 0, pBBEP->width-1, pBBEP->height-1); // buffer layout changed
 } /* bbepSetRotation() */
 
 void bbepWriteImage4bppSpecial(BBEPDISP *pBBEP, uint8_t ucCMD)
@@ -2929,6 +2989,78 @@ static void bbepWriteImage1to4bpp(BBEPDISP *pBBEP, uint8_t ucCMD, uint8_t *pBuff
             break;
     } // switch
 } /* bbepWriteImage1to4bpp() */
+//
+// Transpose an 8x8 bit block: bit (7-j) of output byte j is bit (7-k)
+// of input byte k. Output bytes are inverted if ucInvert is set and
+// stored at pDst[j * iDstPitch]
+// Uses the shift/mask swaps from Hacker's Delight on two 32-bit words
+//
+static void bbepTranspose8(const uint8_t *pIn, uint8_t *pDst, int iDstPitch, uint8_t ucInvert)
+{
+    uint32_t x, y, t;
+
+    x = ((uint32_t)pIn[0] << 24) | ((uint32_t)pIn[1] << 16) | ((uint32_t)pIn[2] << 8) | pIn[3];
+    y = ((uint32_t)pIn[4] << 24) | ((uint32_t)pIn[5] << 16) | ((uint32_t)pIn[6] << 8) | pIn[7];
+    t = (x ^ (x >> 7)) & 0x00aa00aa; x = x ^ t ^ (t << 7); // swap 1x1 blocks
+    t = (y ^ (y >> 7)) & 0x00aa00aa; y = y ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc; x = x ^ t ^ (t << 14); // swap 2x2 blocks
+    t = (y ^ (y >> 14)) & 0x0000cccc; y = y ^ t ^ (t << 14);
+    t = (x & 0xf0f0f0f0) | ((y >> 4) & 0x0f0f0f0f); // swap 4x4 blocks
+    y = ((x << 4) & 0xf0f0f0f0) | (y & 0x0f0f0f0f);
+    x = t;
+    if (ucInvert) {
+        x = ~x; y = ~y;
+    }
+    pDst[0] = (uint8_t)(x >> 24); pDst += iDstPitch;
+    pDst[0] = (uint8_t)(x >> 16); pDst += iDstPitch;
+    pDst[0] = (uint8_t)(x >> 8); pDst += iDstPitch;
+    pDst[0] = (uint8_t)x; pDst += iDstPitch;
+    pDst[0] = (uint8_t)(y >> 24); pDst += iDstPitch;
+    pDst[0] = (uint8_t)(y >> 16); pDst += iDstPitch;
+    pDst[0] = (uint8_t)(y >> 8); pDst += iDstPitch;
+    pDst[0] = (uint8_t)y;
+} /* bbepTranspose8() */
+//
+// Write a 1-bpp plane rotated by 90 or 270 degrees, 8 output rows at a time
+// Each source byte column becomes 8 EPD rows; it's read as 8x8 tiles that
+// are transposed into u8Cache and then sent row by row
+// Returns 0 if the rows don't fit in u8Cache (caller uses the bitwise path)
+//
+static int bbepWriteImageRotated(BBEPDISP *pBBEP, uint8_t *pBuffer, uint8_t ucInvert)
+{
+    int iPitch, iDstPitch, bx, c, j, k, ty;
+    uint8_t u8In[8];
+
+    iPitch = (pBBEP->width + 7) >> 3;
+    iDstPitch = (pBBEP->native_width + 7) >> 3; // native width = source height
+    if (iDstPitch * 8 > (int)sizeof(u8Cache)) {
+        return 0;
+    }
+    for (j=0; j<iPitch; j++) {
+        // 90 walks the source columns left to right, 270 right to left
+        bx = (pBBEP->iOrientation == 90) ? j : iPitch-1-j;
+        for (c=0; c<iDstPitch; c++) {
+            for (k=0; k<8; k++) {
+                if (pBBEP->iOrientation == 90) { // native x runs up from the bottom
+                    ty = pBBEP->height-1-(c*8)-k;
+                } else { // native x runs down from the top
+                    ty = (c*8)+k;
+                }
+                // pixels past the edge are sent as white, like the bitwise version
+                u8In[k] = (ty >= 0 && ty < pBBEP->height) ? pBuffer[bx + (ty * iPitch)] : 0xff;
+            }
+            bbepTranspose8(u8In, &u8Cache[c], iDstPitch, ucInvert);
+        } // for c
+        // send the rows for the source columns which exist
+        for (k=0; k<8; k++) {
+            int tx = (bx*8) + ((pBBEP->iOrientation == 90) ? k : 7-k);
+            if (tx < pBBEP->width) {
+                bbepWriteData(pBBEP, &u8Cache[(tx & 7) * iDstPitch], iDstPitch);
+            }
+        }
+    } // for j
+    return 1;
+} /* bbepWriteImageRotated() */
 
 //
 // Write Image data (1-bpp entire plane) from RAM to the e-paper
@@ -2948,9 +3080,16 @@ static void bbepWriteImage(BBEPDISP *pBBEP, uint8_t ucCMD, uint8_t *pBuffer, int
     if (ucCMD) {
         bbepWriteCmd(pBBEP, ucCMD); // start write
     }
+    bbepBeginData(pBBEP); // send the whole plane as one burst
     // Convert the bit direction and write the data to the EPD
     switch (pBBEP->iOrientation) {
         case 0:
+#ifdef BBEP_DMA_WRITE
+            // the rows are already in wire order; stream them without a copy
+            if (bbepWriteDataDMA(pBBEP, pBuffer, iPitch * pBBEP->native_height, ucInvert)) {
+                break;
+            }
+#endif
             for (ty=0; ty<pBBEP->native_height; ty++) {
                 d = u8Cache;
                 s = &pBuffer[ty * iPitch];
@@ -2960,6 +3099,9 @@ static void bbepWriteImage(BBEPDISP *pBBEP, uint8_t ucCMD, uint8_t *pBuffer, int
             } // for ty
             break;
         case 90:
+            if (bbepWriteImageRotated(pBBEP, pBuffer, ucInvert)) {
+                break;
+            }
             for (tx=0; tx<pBBEP->width; tx++) {
                 d = u8Cache;
                 // need to pick up and reassemble every pixel
@@ -2991,6 +3133,9 @@ static void bbepWriteImage(BBEPDISP *pBBEP, uint8_t ucCMD, uint8_t *pBuffer, int
             } // for ty
             break;
         case 270:
+            if (bbepWriteImageRotated(pBBEP, pBuffer, ucInvert)) {
+                break;
+            }
             for (tx=pBBEP->width-1; tx>=0; tx--) {
                 d = u8Cache;
                 // reassemble every pixel
@@ -3012,6 +3157,7 @@ static void bbepWriteImage(BBEPDISP *pBBEP, uint8_t ucCMD, uint8_t *pBuffer, int
             } // for x
             break;
     } // switch on orientation
+    bbepEndData(pBBEP);
 } /* bbepWriteImage() */
 //
 // Write the local copy of the memory plane(s) to the eink's internal framebuffer
@@ -3025,6 +3171,7 @@ int bbepWritePlane(BBEPDISP *pBBEP, int iPlane, int bInvert)
         return BBEP_ERROR_BAD_PARAMETER;
     }
     bbepSetAddrWindow(pBBEP, 0,0, pBBEP->native_width, pBBEP->native_height);
+    bbepClearDirty(pBBEP); // everything is about to be sent
 
     if (pBBEP->iFlags & BBEP_4BPP_DATA) { // special case for some 2 and 3-color panels
         if (pBBEP->iFlags & BBEP_3COLOR) {
@@ -3085,5 +3232,153 @@ int bbepWritePlane(BBEPDISP *pBBEP, int iPlane, int bInvert)
     }
     return BBEP_SUCCESS;
 } /* bbepWritePlane() */
+//
+// Write a byte-aligned window of a 1-bpp plane; the start/size are in
+// native coordinates (bytes horizontally, rows vertically) and the
+// rotation is applied the same way as bbepWriteImage()
+//
+static void bbepWriteImageRect(BBEPDISP *pBBEP, uint8_t ucCMD, uint8_t *pBuffer, int bInvert, int iStartByte, int iStartRow, int iBytes, int iRows)
+{
+    int tx, ty, nx, ny, iPitch;
+    uint8_t *s, *d, ucSrcMask, ucDstMask, uc;
+    uint8_t ucInvert = 0;
+
+    iPitch = (pBBEP->width + 7) >> 3;
+    if (bInvert) {
+        ucInvert = 0xff; // red logic is inverted
+    }
+    bbepWriteCmd(pBBEP, ucCMD); // start write
+    bbepBeginData(pBBEP);
+    for (ny=iStartRow; ny<iStartRow+iRows; ny++) {
+        d = u8Cache;
+        switch (pBBEP->iOrientation) {
+            case 0:
+                memcpy(d, &pBuffer[(ny * iPitch) + iStartByte], iBytes);
+                if (ucInvert) InvertBytes(d, iBytes);
+                break;
+            case 90: // native row = source column, native x runs bottom to top
+                ucSrcMask = 0x80 >> (ny & 7);
+                for (nx=iStartByte*8; nx<(iStartByte+iBytes)*8; nx+=8) {
+                    uc = 0xff;
+                    ucDstMask = 0x80;
+                    for (ty=pBBEP->height-1-nx; ucDstMask && ty>=0; ty--) {
+                        s = &pBuffer[(ny >> 3) + (ty * iPitch)];
+                        if ((s[0] & ucSrcMask) == 0) uc &= ~ucDstMask;
+                        ucDstMask >>= 1;
+                    }
+                    *d++ = (uc ^ ucInvert);
+                }
+                break;
+            case 180:
+                s = &pBuffer[(pBBEP->native_height-1-ny) * iPitch];
+                for (tx=iPitch-1-iStartByte; tx>iPitch-1-iStartByte-iBytes; tx--) {
+                    *d++ = (ucMirror[s[tx]] ^ ucInvert);
+                }
+                break;
+            case 270: // native row = source column from the right, native x = source y
+                tx = pBBEP->width-1-ny;
+                ucSrcMask = 0x80 >> (tx & 7);
+                for (nx=iStartByte*8; nx<(iStartByte+iBytes)*8; nx+=8) {
+                    uc = 0xff;
+                    ucDstMask = 0x80;
+                    for (ty=nx; ucDstMask && ty<pBBEP->height; ty++) {
+                        s = &pBuffer[(tx >> 3) + (ty * iPitch)];
+                        if ((s[0] & ucSrcMask) == 0) uc &= ~ucDstMask;
+                        ucDstMask >>= 1;
+                    }
+                    *d++ = (uc ^ ucInvert);
+                }
+                break;
+        } // switch on orientation
+        bbepWriteData(pBBEP, u8Cache, iBytes);
+    } // for ny
+    bbepEndData(pBBEP);
+} /* bbepWriteImageRect() */
+//
+// Write only the part of the plane(s) drawn since the last plane write
+// The dirty rectangle is widened to whole bytes in native orientation
+// and sent through the EPD's address window. It's cleared once sent,
+// so write every plane you need in one call (e.g. PLANE_BOTH)
+//
+int bbepWritePlaneDirty(BBEPDISP *pBBEP, int iPlane, int bInvert)
+{
+    uint8_t ucCMD1, ucCMD2;
+    int iOffset, x1, y1, x2, y2, iBytes, iRows;
+
+    if (pBBEP == NULL || pBBEP->ucScreen == NULL || iPlane < PLANE_0 || iPlane > PLANE_DUPLICATE) {
+        return BBEP_ERROR_BAD_PARAMETER;
+    }
+    if (pBBEP->iFlags & (BBEP_4BPP_DATA | BBEP_7COLOR | BBEP_4COLOR)) {
+        return bbepWritePlane(pBBEP, iPlane, bInvert); // no windowed path for these
+    }
+    if (pBBEP->iDirtyX1 > pBBEP->iDirtyX2) {
+        return BBEP_SUCCESS; // nothing drawn since the last write
+    }
+    // Convert the dirty rectangle to native coordinates
+    switch (pBBEP->iOrientation) {
+        default:
+        case 0:
+            x1 = pBBEP->iDirtyX1; x2 = pBBEP->iDirtyX2;
+            y1 = pBBEP->iDirtyY1; y2 = pBBEP->iDirtyY2;
+            break;
+        case 90:
+            x1 = pBBEP->height-1-pBBEP->iDirtyY2; x2 = pBBEP->height-1-pBBEP->iDirtyY1;
+            y1 = pBBEP->iDirtyX1; y2 = pBBEP->iDirtyX2;
+            break;
+        case 180: // bbepWriteImage mirrors whole bytes
+            x1 = (((pBBEP->width+7) & ~7)-1) - pBBEP->iDirtyX2;
+            x2 = (((pBBEP->width+7) & ~7)-1) - pBBEP->iDirtyX1;
+            y1 = pBBEP->height-1-pBBEP->iDirtyY2; y2 = pBBEP->height-1-pBBEP->iDirtyY1;
+            break;
+        case 270:
+            x1 = pBBEP->iDirtyY1; x2 = pBBEP->iDirtyY2;
+            y1 = pBBEP->width-1-pBBEP->iDirtyX2; y2 = pBBEP->width-1-pBBEP->iDirtyX1;
+            break;
+    }
+    iBytes = (x2 >> 3) - (x1 >> 3) + 1;
+    iRows = y2 - y1 + 1;
+    x1 >>= 3;
+    bbepSetAddrWindow(pBBEP, x1*8, y1, iBytes*8, iRows);
+    bbepClearDirty(pBBEP);
+
+    if (pBBEP->chip_type == BBEP_CHIP_UC81xx) {
+        if (pBBEP->iFlags & BBEP_RED_SWAPPED) {
+            ucCMD1 = UC8151_DTM1;
+            ucCMD2 = UC8151_DTM2;
+        } else {
+            ucCMD1 = UC8151_DTM2;
+            ucCMD2 = UC8151_DTM1;
+        }
+    } else {
+        ucCMD1 = SSD1608_WRITE_RAM;
+        ucCMD2 = SSD1608_WRITE_ALTRAM;
+    }
+    iOffset = ((pBBEP->native_width+7)>>3) * pBBEP->native_height;
+    if (pBBEP->iFlags & BBEP_3COLOR && iPlane == PLANE_DUPLICATE) {
+        iPlane = PLANE_BOTH;
+    }
+    switch (iPlane) {
+        case PLANE_0:
+            bbepWriteImageRect(pBBEP, ucCMD1, pBBEP->ucScreen, bInvert, x1, y1, iBytes, iRows);
+            break;
+        case PLANE_1:
+            bbepWriteImageRect(pBBEP, ucCMD2, &pBBEP->ucScreen[iOffset], bInvert, x1, y1, iBytes, iRows);
+            break;
+        case PLANE_0_TO_1:
+            bbepWriteImageRect(pBBEP, ucCMD2, pBBEP->ucScreen, bInvert, x1, y1, iBytes, iRows);
+            break;
+        case PLANE_BOTH:
+            bbepWriteImageRect(pBBEP, ucCMD1, pBBEP->ucScreen, bInvert, x1, y1, iBytes, iRows);
+            if (pBBEP->iFlags & BBEP_HAS_SECOND_PLANE) {
+                bbepWriteImageRect(pBBEP, ucCMD2, &pBBEP->ucScreen[iOffset], bInvert, x1, y1, iBytes, iRows);
+            }
+            break;
+        case PLANE_DUPLICATE:
+            bbepWriteImageRect(pBBEP, ucCMD1, pBBEP->ucScreen, bInvert, x1, y1, iBytes, iRows);
+            bbepWriteImageRect(pBBEP, ucCMD2, pBBEP->ucScreen, bInvert, x1, y1, iBytes, iRows);
+            break;
+    }
+    return BBEP_SUCCESS;
+} /* bbepWritePlaneDirty() */
 
 #endif // __BB_EP__
@@ -256,8 +256,8 @@ uint8_t szExtMsg[80];
 //
 void bbepDrawSprite(BBEPDISP *pBBEP, const uint8_t *pSprite, int cx, int cy, int iPitch, int x, int y, uint8_t iColor)
 {
-    int tx, ty, dx, dy, iStartX;
-    uint8_t *s, pix, ucSrcMask;
+    int ty, dx, dy, iStartX;
+    uint8_t *s;
     
     if (pBBEP == NULL) return;
     if (x+cx < 0 || y+cy < 0 || x >= pBBEP->native_width || y >= pBBEP->native_height) {
@@ -334,21 +334,11 @@ void bbepDrawSprite(BBEPDISP *pBBEP, const uint8_t *pSprite, int cx, int cy, int
         }
         if (x + cx > pBBEP->native_width)
             cx = pBBEP->native_width - x;
+        bbepMarkDirty(pBBEP, dx, dy, dx+cx-1, dy+cy-1);
         for (ty=0; ty<cy; ty++)
         {
-            s = (uint8_t *)&pSprite[(iStartX >> 3)];
-            ucSrcMask = 0x80 >> (iStartX & 7);
-            pix = *s++;
-            for (tx=0; tx<cx; tx++) {
-                if (pix & ucSrcMask) { // set pixel in source, set it in dest
-                    (*pBBEP->pfnSetPixelFast)(pBBEP, dx+tx, dy+ty, iColor);
-                }
-                ucSrcMask >>= 1;
-                if (ucSrcMask == 0) { // read next byte
-                    ucSrcMask = 0x80;
-                    pix = *s++;
-                }
-            } // for tx
+            (*pBBEP->pfnBlitRow)(pBBEP, &pSprite[(iStartX >> 3)], 0x80 >> (iStartX & 7), 65536,
+                                 dx, dy+ty, cx, iColor, BBEP_TRANSPARENT);
             pSprite += iPitch;
         } // for ty
 #endif // NO_RAM
@@ -611,6 +601,406 @@ void bbepSetPixelFast16Clr(void *pb, int x, int y, unsigned char ucColor)
     }
     pBBEP->ucScreen[i] = u8;
 } /* bbepSetPixelFast16Clr() */
+//
+// Pixel format specialized drawing kernels
+// The generic primitives go through pfnSetPixelFast, which reloads the
+// pitch, plane size and plane number from BBEPDISP for every pixel. The
+// kernels below are instantiated once per buffer layout with those values
+// hoisted out of their loops; bbepSelectKernels() picks the instantiation
+// when the panel type is set.
+//
+enum {
+    BBEP_PIX_2CLR = 0, // 1-bpp, plane chosen by iPlane
+    BBEP_PIX_3CLR,     // 1-bpp B/W plane + 1-bpp red/yellow plane
+    BBEP_PIX_4GRAY,    // 1-bpp low bit plane + 1-bpp high bit plane
+    BBEP_PIX_4CLR,     // 2-bpp packed
+    BBEP_PIX_16CLR,    // 4-bpp packed
+    BBEP_PIX_GENERIC   // anything else, uses pfnSetPixelFast
+};
+
+typedef struct bbep_pix_tag
+{
+    BBEPDISP *pBBEP;
+    uint8_t *pPlane0; // plane being drawn into
+    uint8_t *pPlane1; // red plane (3-color) or high bit plane (4-gray)
+    int iPitch;
+} BBEP_PIX;
+
+template <int FMT>
+static inline void bbepPixInit(BBEPDISP *pBBEP, BBEP_PIX *pPix)
+{
+    int iSize = ((pBBEP->native_width+7)>>3) * pBBEP->native_height;
+
+    pPix->pBBEP = pBBEP;
+    pPix->pPlane0 = pBBEP->ucScreen;
+    pPix->pPlane1 = &pBBEP->ucScreen[iSize];
+    if (FMT == BBEP_PIX_4CLR) {
+        pPix->iPitch = (pBBEP->width+3)>>2;
+    } else if (FMT == BBEP_PIX_16CLR) {
+        pPix->iPitch = pBBEP->width>>1;
+    } else {
+        pPix->iPitch = (pBBEP->width+7)>>3;
+    }
+    if (FMT == BBEP_PIX_2CLR && pBBEP->iPlane == PLANE_1) {
+        pPix->pPlane0 = pPix->pPlane1;
+    }
+} /* bbepPixInit() */
+
+template <int FMT>
+static inline void bbepPixSet(const BBEP_PIX *pPix, int x, int y, uint8_t ucColor)
+{
+    int i;
+    uint8_t u8Mask;
+
+    if (FMT == BBEP_PIX_2CLR) {
+        i = (x >> 3) + (y * pPix->iPitch);
+        u8Mask = 0x80 >> (x & 7);
+        if (ucColor == BBEP_WHITE) {
+            pPix->pPlane0[i] |= u8Mask;
+        } else {
+            pPix->pPlane0[i] &= ~u8Mask;
+        }
+    } else if (FMT == BBEP_PIX_3CLR) {
+        i = (x >> 3) + (y * pPix->iPitch);
+        u8Mask = 0x80 >> (x & 7);
+        if (ucColor >= BBEP_YELLOW) { // yellow/red has priority
+            pPix->pPlane1[i] |= u8Mask;
+        } else {
+            pPix->pPlane1[i] &= ~u8Mask;
+            if (ucColor == BBEP_WHITE) {
+                pPix->pPlane0[i] |= u8Mask;
+            } else {
+                pPix->pPlane0[i] &= ~u8Mask;
+            }
+        }
+    } else if (FMT == BBEP_PIX_4GRAY) {
+        i = (x >> 3) + (y * pPix->iPitch);
+        u8Mask = 0x80 >> (x & 7);
+        if (ucColor & 1) {
+            pPix->pPlane0[i] |= u8Mask;
+        } else {
+            pPix->pPlane0[i] &= ~u8Mask;
+        }
+        if (ucColor & 2) {
+            pPix->pPlane1[i] |= u8Mask;
+        } else {
+            pPix->pPlane1[i] &= ~u8Mask;
+        }
+    } else if (FMT == BBEP_PIX_4CLR) {
+        i = (x >> 2) + (y * pPix->iPitch);
+        u8Mask = 0xc0 >> ((x & 3)*2);
+        pPix->pPlane0[i] = (pPix->pPlane0[i] & ~u8Mask) | (uint8_t)(ucColor << ((3-(x & 3))*2));
+    } else if (FMT == BBEP_PIX_16CLR) {
+        i = (x >> 1) + (y * pPix->iPitch);
+        if (x & 1) {
+            pPix->pPlane0[i] = (pPix->pPlane0[i] & 0xf0) | ucColor;
+        } else {
+            pPix->pPlane0[i] = (pPix->pPlane0[i] & 0x0f) | (ucColor << 4);
+        }
+    } else {
+        (*pPix->pBBEP->pfnSetPixelFast)(pPix->pBBEP, x, y, ucColor);
+    }
+} /* bbepPixSet() */
+//
+// Bresenham line; takes a translated color and on-screen end points
+//
+template <int FMT>
+static void bbepDrawLineT(void *pb, int x1, int y1, int x2, int y2, unsigned char ucColor)
+{
+    BBEPDISP *pBBEP = (BBEPDISP *)pb;
+    BBEP_PIX pix;
+    int temp, error, xinc, yinc;
+    int dx = x2 - x1;
+    int dy = y2 - y1;
+
+    bbepPixInit<FMT>(pBBEP, &pix);
+    if(abs(dx) > abs(dy)) {
+        // X major case
+        if(x2 < x1) {
+            dx = -dx;
+            temp = x1;
+            x1 = x2;
+            x2 = temp;
+            temp = y1;
+            y1 = y2;
+            y2 = temp;
+        }
+        dy = (y2 - y1);
+        error = dx >> 1;
+        yinc = 1;
+        if (dy < 0) {
+            dy = -dy;
+            yinc = -1;
+        }
+        for(; x1 <= x2; x1++) {
+            bbepPixSet<FMT>(&pix, x1, y1, ucColor);
+            error -= dy;
+            if (error < 0) {
+                error += dx;
+                y1 += yinc;
+            }
+        } // for x1
+    } else {
+        // Y major case
+        if(y1 > y2) {
+            dy = -dy;
+            temp = x1;
+            x1 = x2;
+            x2 = temp;
+            temp = y1;
+            y1 = y2;
+            y2 = temp;
+        }
+        dx = (x2 - x1);
+        error = dy >> 1;
+        xinc = 1;
+        if (dx < 0) {
+            dx = -dx;
+            xinc = -1;
+        }
+        for(; y1 <= y2; y1++) {
+            bbepPixSet<FMT>(&pix, x1, y1, ucColor);
+            error -= dx;
+            if (error < 0) {
+                error += dy;
+                x1 += xinc;
+            }
+        } // for y
+    } // y major case
+} /* bbepDrawLineT() */
+//
+// Set (0xff) or clear (0x00) masks for the bits of one 1-bpp plane when a
+// color is drawn; both are 0 when the plane isn't touched
+//
+template <int FMT>
+static inline void bbepPlaneMasks(int iColor, int iPlane, uint8_t *pSet, uint8_t *pClr)
+{
+    int iBit = -1; // -1 = leave the plane alone
+
+    if (iColor != BBEP_TRANSPARENT) {
+        if (FMT == BBEP_PIX_2CLR) {
+            iBit = (iColor == BBEP_WHITE);
+        } else if (FMT == BBEP_PIX_3CLR) { // yellow/red has priority
+            if (iPlane == 1) {
+                iBit = (iColor >= BBEP_YELLOW);
+            } else if (iColor < BBEP_YELLOW) {
+                iBit = (iColor == BBEP_WHITE);
+            }
+        } else { // 4-gray, one bit of the color per plane
+            iBit = (iColor >> iPlane) & 1;
+        }
+    }
+    *pSet = (iBit == 1) ? 0xff : 0;
+    *pClr = (iBit == 0) ? 0xff : 0;
+} /* bbepPlaneMasks() */
+//
+// Draw cx pixels of a byte aligned 1-bpp source row into one 1-bpp plane
+// row at x, a destination byte at a time. The source bytes are shifted
+// into place and the 1 and 0 bits set or cleared with the masks from
+// bbepPlaneMasks()
+//
+static void bbepBlitPlaneRow(uint8_t *pDst, const uint8_t *pSrc, int x, int cx, uint8_t u8FGSet, uint8_t u8FGClr, uint8_t u8BGSet, uint8_t u8BGClr)
+{
+    int j, iShift = x & 7;
+    int iSrcBytes = (cx + 7) >> 3;
+    int iDstBytes = (iShift + cx + 7) >> 3;
+    uint8_t u8Prev = 0, u8Cur, u8Src, u8Mask, u8Set, u8Clr;
+
+    pDst += (x >> 3);
+    for (j=0; j<iDstBytes; j++) {
+        u8Cur = (j < iSrcBytes) ? pSrc[j] : 0;
+        u8Src = (uint8_t)((u8Prev << (8 - iShift)) | (u8Cur >> iShift));
+        u8Prev = u8Cur;
+        u8Mask = 0xff;
+        if (j == 0) u8Mask >>= iShift;
+        if (j == iDstBytes-1) u8Mask &= (uint8_t)(0xff << (7 - ((iShift + cx - 1) & 7)));
+        u8Set = ((u8Src & u8FGSet) | (~u8Src & u8BGSet)) & u8Mask;
+        u8Clr = ((u8Src & u8FGClr) | (~u8Src & u8BGClr)) & u8Mask;
+        pDst[j] = (pDst[j] & ~u8Clr) | u8Set;
+    }
+} /* bbepBlitPlaneRow() */
+//
+// Draw cx pixels of a 1-bpp (MSB first) source row starting at x,y
+// 1 bits are drawn in iFG and 0 bits in iBG; either can be BBEP_TRANSPARENT
+// u32Step is the 16.16 source advance per destination pixel (65536 = 1:1)
+// Takes translated colors; the caller clips the row to the display
+//
+template <int FMT>
+static void bbepBlitRowT(void *pb, const uint8_t *pSrc, uint8_t u8SrcMask, uint32_t u32Step, int x, int y, int cx, int iFG, int iBG)
+{
+    BBEPDISP *pBBEP = (BBEPDISP *)pb;
+    BBEP_PIX pix;
+    uint32_t u32Acc = 0;
+    uint8_t u8;
+    int tx;
+
+    bbepPixInit<FMT>(pBBEP, &pix);
+    if ((FMT == BBEP_PIX_2CLR || FMT == BBEP_PIX_3CLR || FMT == BBEP_PIX_4GRAY) &&
+        u32Step == 65536 && u8SrcMask == 0x80 && x >= 0 && cx > 0) { // 1:1 and byte aligned, OR/AND whole bytes
+        uint8_t u8FGSet, u8FGClr, u8BGSet, u8BGClr;
+        tx = y * pix.iPitch;
+        bbepPlaneMasks<FMT>(iFG, 0, &u8FGSet, &u8FGClr);
+        bbepPlaneMasks<FMT>(iBG, 0, &u8BGSet, &u8BGClr);
+        bbepBlitPlaneRow(&pix.pPlane0[tx], pSrc, x, cx, u8FGSet, u8FGClr, u8BGSet, u8BGClr);
+        if (FMT != BBEP_PIX_2CLR) {
+            bbepPlaneMasks<FMT>(iFG, 1, &u8FGSet, &u8FGClr);
+            bbepPlaneMasks<FMT>(iBG, 1, &u8BGSet, &u8BGClr);
+            bbepBlitPlaneRow(&pix.pPlane1[tx], pSrc, x, cx, u8FGSet, u8FGClr, u8BGSet, u8BGClr);
+        }
+        return;
+    }
+    u8 = *pSrc++;
+    for (tx=x; tx<x+cx; tx++) {
+        if (u8 & u8SrcMask) {
+            if (iFG != BBEP_TRANSPARENT) {
+                bbepPixSet<FMT>(&pix, tx, y, (uint8_t)iFG);
+            }
+        } else if (iBG != BBEP_TRANSPARENT) {
+            bbepPixSet<FMT>(&pix, tx, y, (uint8_t)iBG);
+        }
+        u32Acc += u32Step;
+        while (u32Acc >= 65536) { // whole source pixel movement
+            u32Acc -= 65536;
+            u8SrcMask >>= 1;
+            if (u8SrcMask == 0) { // need to load the next byte
+                u8SrcMask = 0x80;
+                u8 = *pSrc++;
+            }
+        }
+    } // for tx
+} /* bbepBlitRowT() */
+//
+// Pick the kernel instantiations matching the panel's pixel functions
+//
+void bbepSelectKernels(BBEPDISP *pBBEP)
+{
+    if (pBBEP->pfnSetPixelFast == bbepSetPixelFast2Clr) {
+        pBBEP->pfnDrawLine = bbepDrawLineT<BBEP_PIX_2CLR>;
+        pBBEP->pfnBlitRow = bbepBlitRowT<BBEP_PIX_2CLR>;
+    } else if (pBBEP->pfnSetPixelFast == bbepSetPixelFast3Clr) {
+        pBBEP->pfnDrawLine = bbepDrawLineT<BBEP_PIX_3CLR>;
+        pBBEP->pfnBlitRow = bbepBlitRowT<BBEP_PIX_3CLR>;
+    } else if (pBBEP->pfnSetPixelFast == bbepSetPixelFast4Gray) {
+        pBBEP->pfnDrawLine = bbepDrawLineT<BBEP_PIX_4GRAY>;
+        pBBEP->pfnBlitRow = bbepBlitRowT<BBEP_PIX_4GRAY>;
+    } else if (pBBEP->pfnSetPixelFast == bbepSetPixelFast4Clr) {
+        pBBEP->pfnDrawLine = bbepDrawLineT<BBEP_PIX_4CLR>;
+        pBBEP->pfnBlitRow = bbepBlitRowT<BBEP_PIX_4CLR>;
+    } else if (pBBEP->pfnSetPixelFast == bbepSetPixelFast16Clr) {
+        pBBEP->pfnDrawLine = bbepDrawLineT<BBEP_PIX_16CLR>;
+        pBBEP->pfnBlitRow = bbepBlitRowT<BBEP_PIX_16CLR>;
+    } else {
+        pBBEP->pfnDrawLine = bbepDrawLineT<BBEP_PIX_GENERIC>;
+        pBBEP->pfnBlitRow = bbepBlitRowT<BBEP_PIX_GENERIC>;
+    }
+} /* bbepSelectKernels() */
+//
+// Draw decoded Group5 lines as runs of color straight into the 1-bpp
+// planes, without expanding them into a row of pixels first
+// bbepRunFillInit() works out the planes and masks once per image
+//
+typedef struct bbep_run_fill_tag
+{
+    uint8_t *pPlane[2]; // pPlane[1] is NULL for single plane layouts
+    int iPitch;
+    uint8_t u8Set[2][2], u8Clr[2][2]; // [plane][0 = BG, 1 = FG]
+} BBEP_RUN_FILL;
+
+template <int FMT>
+static void bbepRunFillInitT(BBEPDISP *pBBEP, BBEP_RUN_FILL *pRF, int iFG, int iBG)
+{
+    BBEP_PIX pix;
+    int i;
+
+    bbepPixInit<FMT>(pBBEP, &pix);
+    pRF->pPlane[0] = pix.pPlane0;
+    pRF->pPlane[1] = (FMT == BBEP_PIX_2CLR) ? NULL : pix.pPlane1;
+    pRF->iPitch = pix.iPitch;
+    for (i=0; i<2; i++) {
+        bbepPlaneMasks<FMT>(iBG, i, &pRF->u8Set[i][0], &pRF->u8Clr[i][0]);
+        bbepPlaneMasks<FMT>(iFG, i, &pRF->u8Set[i][1], &pRF->u8Clr[i][1]);
+    }
+} /* bbepRunFillInitT() */
+//
+// Takes translated colors; returns 0 if the display doesn't use 1-bpp planes
+//
+static int bbepRunFillInit(BBEPDISP *pBBEP, BBEP_RUN_FILL *pRF, int iFG, int iBG)
+{
+    if (pBBEP->pfnSetPixelFast == bbepSetPixelFast2Clr) {
+        bbepRunFillInitT<BBEP_PIX_2CLR>(pBBEP, pRF, iFG, iBG);
+    } else if (pBBEP->pfnSetPixelFast == bbepSetPixelFast3Clr) {
+        bbepRunFillInitT<BBEP_PIX_3CLR>(pBBEP, pRF, iFG, iBG);
+    } else if (pBBEP->pfnSetPixelFast == bbepSetPixelFast4Gray) {
+        bbepRunFillInitT<BBEP_PIX_4GRAY>(pBBEP, pRF, iFG, iBG);
+    } else {
+        return 0;
+    }
+    return 1;
+} /* bbepRunFillInit() */
+//
+// Set or clear bits x1 through x2 of a 1-bpp row
+//
+static inline void bbepRunFillBits(uint8_t *pRow, int x1, int x2, uint8_t u8Set, uint8_t u8Clr)
+{
+    int iFirst = x1 >> 3, iLast = x2 >> 3;
+    uint8_t u8Left = 0xff >> (x1 & 7);
+    uint8_t u8Right = (uint8_t)(0xff << (7 - (x2 & 7)));
+
+    if (iFirst == iLast) { // run fits in a single byte
+        u8Left &= u8Right;
+        pRow[iFirst] = (pRow[iFirst] & ~(u8Clr & u8Left)) | (u8Set & u8Left);
+        return;
+    }
+    pRow[iFirst] = (pRow[iFirst] & ~(u8Clr & u8Left)) | (u8Set & u8Left);
+    pRow[iLast] = (pRow[iLast] & ~(u8Clr & u8Right)) | (u8Set & u8Right);
+    if (iLast - iFirst > 1) { // the masks are all or nothing, so u8Set is the byte value
+        memset(&pRow[iFirst+1], u8Set, iLast - iFirst - 1);
+    }
+} /* bbepRunFillBits() */
+//
+// Draw the first cx pixels of a line from g5_decode_flips() at x,y
+// The black runs are drawn in BG and the white pixels around them in FG,
+// matching what bbepLoadG5() draws from the decoded pixels. Each plane
+// gets one fill per run at most: when both colors change it, the row is
+// filled with FG and the runs drawn over it in BG, like G5DrawLine() does
+//
+static void bbepRunFillLine(const BBEP_RUN_FILL *pRF, const int16_t *pFlips, int iWidth, int x, int y, int cx)
+{
+    int i, iPos, iBlack, iWhite, bFG, bBG;
+    const int16_t *p;
+    uint8_t *pRow;
+
+    for (i=0; i<2 && pRF->pPlane[i]; i++) {
+        pRow = &pRF->pPlane[i][y * pRF->iPitch];
+        bFG = (pRF->u8Set[i][1] | pRF->u8Clr[i][1]) != 0; // 0 = transparent for this plane
+        bBG = (pRF->u8Set[i][0] | pRF->u8Clr[i][0]) != 0;
+        if (bFG && bBG) {
+            bbepRunFillBits(pRow, x, x+cx-1, pRF->u8Set[i][1], pRF->u8Clr[i][1]);
+            if (pRF->u8Set[i][0] == pRF->u8Set[i][1]) continue; // same bit either way
+            bFG = 0; // only the runs are left to draw
+        }
+        iPos = 0; // start of the current white gap
+        p = pFlips;
+        while (iPos < cx) {
+            iBlack = *p++;
+            iWhite = *p++;
+            if (iBlack >= iWidth || iWhite == iBlack) break; // no more black runs
+            if (iBlack < iPos) iBlack = iPos;
+            if (iWhite > cx) iWhite = cx;
+            if (bFG && iBlack > iPos) {
+                bbepRunFillBits(pRow, x+iPos, x+((iBlack < cx) ? iBlack : cx)-1, pRF->u8Set[i][1], pRF->u8Clr[i][1]);
+            }
+            if (bBG && iWhite > iBlack) {
+                bbepRunFillBits(pRow, x+iBlack, x+iWhite-1, pRF->u8Set[i][0], pRF->u8Clr[i][0]);
+            }
+            if (iWhite > iPos) iPos = iWhite;
+        }
+        if (bFG && iPos < cx) { // white to the end of the line
+            bbepRunFillBits(pRow, x+iPos, x+cx-1, pRF->u8Set[i][1], pRF->u8Clr[i][1]);
+        }
+    } // for each plane
+} /* bbepRunFillLine() */
+
 
 //
 // Invert font data
@@ -625,50 +1015,59 @@ void InvertBytes(uint8_t *pData, uint8_t bLen)
     }
 } /* InvertBytes() */
 //
-// Load a 1-bpp Group5 compressed bitmap
-// Pass the pointer to the beginning of the G5 file
-// If the FG == BG color, and there is a back buffer, it will
-// draw the 1's bits as the FG color and leave
-// the background (0 pixels) unchanged - aka transparent.
+// Draw the image g5dec was initialized with (cx x cy pixels)
+// Shared by bbepLoadG5() and bbepLoadG5Stream()
 //
-int bbepLoadG5(BBEPDISP *pBBEP, const uint8_t *pG5, int x, int y, int iFG, int iBG, float fScale)
+static int bbepDrawG5(BBEPDISP *pBBEP, int cx, int cy, int x, int y, int iFG, int iBG, float fScale)
 {
-    uint16_t rc, tx, ty, cx, cy, dx, dy, size;
+    uint16_t ty, dx, dy;
     int width, height;
-    BB_BITMAP *pbbb;
-    uint32_t u32Frac, u32XAcc, u32YAcc; // integer fraction vars
+    uint32_t u32Frac, u32YAcc; // integer fraction vars
+#ifndef NO_RAM
+    BBEP_RUN_FILL rf;
+#endif
 
-    if (pBBEP == NULL || pG5 == NULL || fScale < 0.01) return BBEP_ERROR_BAD_PARAMETER;
     if (iFG != BBEP_TRANSPARENT) {
         iFG = pBBEP->pColorLookup[iFG & 0xf]; // translate the color for this display type
     }
     if (iBG != BBEP_TRANSPARENT) {
         iBG = pBBEP->pColorLookup[iBG & 0xf];
     }
-    pbbb = (BB_BITMAP *)pG5;
-    if (pgm_read_word(&pbbb->u16Marker) != BB_BITMAP_MARKER) return BBEP_ERROR_BAD_DATA;
     u32Frac = (uint32_t)(65536.0f / fScale); // calculate the fraction to advance the destination x/y
-    cx = pgm_read_word(&pbbb->width);
-    cy = pgm_read_word(&pbbb->height);
     width = pBBEP->width;
     height = pBBEP->height;
     // Calculate scaled destination size
     dx = (int)(fScale * (float)cx);
     dy = (int)(fScale * (float)cy);
-    size = pgm_read_word(&pbbb->size);
     if (iFG == -1) iFG = BBEP_WHITE;
     if (iBG == -1) iBG = BBEP_BLACK;
-    rc = g5_decode_init(&g5dec, cx, cy, (uint8_t *)&pbbb[1], size);
-    if (rc != G5_SUCCESS) return BBEP_ERROR_BAD_DATA; // corrupt data?
     if (!pBBEP->ucScreen) { // no back buffer
         bbepSetAddrWindow(pBBEP, x, y, cx+(x&7), cy);
         bbepStartWrite(pBBEP, pBBEP->iPlane); // get ready to write
         dy = cy; // scaling is only supported on internal framebuffers
         u32Frac = 65536; // force to 1.0 scale
     }
+    if (pBBEP->ucScreen) {
+        bbepMarkDirty(pBBEP, x, y, x+dx-1, y+dy-1);
+    }
+#ifndef NO_RAM
+    if (pBBEP->ucScreen && u32Frac == 65536 && x >= 0 && bbepRunFillInit(pBBEP, &rf, iFG, iBG)) {
+        // 1:1 onto 1-bpp planes; draw each line's runs as it's decoded
+        int iCount = (x+dx > width) ? width - x : dx; // clip to the right edge
+        for (ty=y; ty<y+dy && ty < height; ty++) {
+            int16_t *pFlips;
+            g5_decode_flips(&g5dec, &pFlips);
+            if (pFlips == NULL) break; // corrupt data
+            if (iCount > 0) {
+                bbepRunFillLine(&rf, pFlips, cx, x, ty, iCount);
+            }
+        }
+        return BBEP_SUCCESS;
+    }
+#endif // NO_RAM
     u32YAcc = 65536; // force first line to get decoded
     for (ty=y; ty<y+dy && ty < height; ty++) {
-        uint8_t u8, *s, src_mask;
+        uint8_t *s;
         while (u32YAcc >= 65536) { // advance to next source line
             g5_decode_line(&g5dec, u8Cache);
             u32YAcc -= 65536;
@@ -697,35 +1096,58 @@ int bbepLoadG5(BBEPDISP *pBBEP, const uint8_t *pG5, int x, int y, int iFG, int i
             bbepWriteData(pBBEP, u8Cache, (cx+(x&7)+7)>>3);
         } else { // use the setPixel function for more features
 #ifndef NO_RAM
-            s = u8Cache;
-            u32XAcc = 0;
-            u8 = *s++; // grab first source byte (8 pixels)
-            src_mask = 0x80;
-            for (tx=x; tx<x+dx && tx < width; tx++) {
-                if (u8 & src_mask) {
-                    if (iFG != BBEP_TRANSPARENT)
-                        (*pBBEP->pfnSetPixelFast)(pBBEP, tx, ty, (uint8_t)iFG);
-                } else {
-                    if (iBG != BBEP_TRANSPARENT)
-                        (*pBBEP->pfnSetPixelFast)(pBBEP, tx, ty, (uint8_t)iBG);
-                }
-                u32XAcc += u32Frac;
-                while (u32XAcc >= 65536) {
-                    u32XAcc -= 65536; // whole source pixel horizontal movement
-                    src_mask >>= 1;
-                    if (src_mask == 0) { // need to load the next byte
-                        u8 = *s++;
-                        src_mask = 0x80;
-                    }
-                }
-            } // for tx
+            int iCount = (x+dx > width) ? width - x : dx; // clip to the right edge
+            if (iCount > 0) {
+                (*pBBEP->pfnBlitRow)(pBBEP, u8Cache, 0x80, u32Frac, x, ty, iCount, iFG, iBG);
+            }
 #endif // NO_RAM
         }
         u32YAcc += u32Frac;
     } // for y
     return BBEP_SUCCESS;
+} /* bbepDrawG5() */
+//
+// Load a 1-bpp Group5 compressed bitmap
+// Pass the pointer to the beginning of the G5 file
+// If the FG == BG color, and there is a back buffer, it will
+// draw the 1's bits as the FG color and leave
+// the background (0 pixels) unchanged - aka transparent.
+//
+int bbepLoadG5(BBEPDISP *pBBEP, const uint8_t *pG5, int x, int y, int iFG, int iBG, float fScale)
+{
+    uint16_t rc, cx, cy, size;
+    BB_BITMAP *pbbb;
+
+    if (pBBEP == NULL || pG5 == NULL || fScale < 0.01) return BBEP_ERROR_BAD_PARAMETER;
+    pbbb = (BB_BITMAP *)pG5;
+    if (pgm_read_word(&pbbb->u16Marker) != BB_BITMAP_MARKER) return BBEP_ERROR_BAD_DATA;
+    cx = pgm_read_word(&pbbb->width);
+    cy = pgm_read_word(&pbbb->height);
+    size = pgm_read_word(&pbbb->size);
+    rc = g5_decode_init(&g5dec, cx, cy, (uint8_t *)&pbbb[1], size);
+    if (rc != G5_SUCCESS) return BBEP_ERROR_BAD_DATA; // corrupt data?
+    return bbepDrawG5(pBBEP, cx, cy, x, y, iFG, iBG, fScale);
 } /* bbepLoadG5() */
 //
+// Load a 1-bpp Group5 compressed bitmap which isn't in memory
+// pfnRead supplies the G5 file (BB_BITMAP header + data) from its start
+// a block at a time, e.g. from a file on a flash filesystem, so only a
+// small window of it is held in RAM. Otherwise the same as bbepLoadG5()
+//
+int bbepLoadG5Stream(BBEPDISP *pBBEP, BBEP_READ_CB *pfnRead, void *pUser, int x, int y, int iFG, int iBG, float fScale)
+{
+    BB_BITMAP bbb;
+    uint8_t u8Window[BBEP_G5_STREAM_BUF];
+
+    if (pBBEP == NULL || pfnRead == NULL || fScale < 0.01) return BBEP_ERROR_BAD_PARAMETER;
+    if ((*pfnRead)(pUser, (uint8_t *)&bbb, sizeof(bbb)) != sizeof(bbb)) return BBEP_ERROR_BAD_DATA;
+    if (bbb.u16Marker != BB_BITMAP_MARKER) return BBEP_ERROR_BAD_DATA;
+    if (g5_decode_init_stream(&g5dec, bbb.width, bbb.height, pfnRead, pUser, bbb.size, u8Window, sizeof(u8Window)) != G5_SUCCESS) {
+        return BBEP_ERROR_BAD_DATA; // corrupt data?
+    }
+    return bbepDrawG5(pBBEP, bbb.width, bbb.height, x, y, iFG, iBG, fScale);
+} /* bbepLoadG5Stream() */
+//
 // Load a 1-bpp Windows bitmap
 // Pass the pointer to the beginning of the BMP file
 // If the FG == BG color, it will
@@ -793,6 +1215,9 @@ int bbepLoadBMP(BBEPDISP *pBBEP, const uint8_t *pBMP, int dx, int dy, int iFG, i
         iFG = iBG;
         iBG = x; // swap colors
     }
+    if (pBBEP->ucScreen) {
+        bbepMarkDirty(pBBEP, dx, dy, dx+cx-1, dy+cy-1);
+    }
     for (y=0; y<cy; y++) {
         s = (uint8_t *)&pBMP[iOffBits + (y*iPitch)];
         if (!pBBEP->ucScreen) {
@@ -915,6 +1340,7 @@ int bbepLoadBMP3(BBEPDISP *pBBEP, const uint8_t *pBMP, int dx, int dy)
             ucColorMap[x] = ((0x1c - uc) < uc) ? BBEP_RED : BBEP_BLACK;
         }
     }
+    bbepMarkDirty(pBBEP, 0, 0, pBBEP->width-1, pBBEP->height-1); // written in its own layout
     for (y=0; y<cy; y++)
     {
         dst_mask = 1 << ((y+dy) & 7);
@@ -1082,15 +1508,100 @@ uint16_t u16CP; // 16-bit codepoint encoded by the multi-byte sequence
     } // while szMsg[i]
     szExtMsg[j++] = 0; // zero terminate it
 } /* bbepUnicodeString() */
+#ifndef BBEP_PSRAM_MALLOC
+#define BBEP_PSRAM_MALLOC(n) malloc(n)
+#endif
+//
+// Set up an LRU cache of decoded custom font glyphs so text that is
+// redrawn doesn't need to be decompressed again. iGlyphs glyphs of up to
+// iMaxGlyphBytes of 1-bpp rows are kept; larger glyphs are always decoded.
+// 0 glyphs frees the cache.
+//
+int bbepSetGlyphCache(BBEPDISP *pBBEP, int iGlyphs, int iMaxGlyphBytes)
+{
+    BBEP_GLYPH_CACHE *pCache;
+    int iSize;
+
+    if (pBBEP == NULL) return BBEP_ERROR_BAD_PARAMETER;
+    if (pBBEP->pGlyphCache) {
+        free(pBBEP->pGlyphCache);
+        pBBEP->pGlyphCache = NULL;
+    }
+    if (iGlyphs <= 0) return BBEP_SUCCESS;
+    if (iMaxGlyphBytes <= 0) return BBEP_ERROR_BAD_PARAMETER;
+    iMaxGlyphBytes = (iMaxGlyphBytes + 3) & ~3; // keep the rows word aligned
+    iSize = sizeof(BBEP_GLYPH_CACHE) + iGlyphs * (sizeof(BBEP_GLYPH_SLOT) + iMaxGlyphBytes);
+    pCache = (BBEP_GLYPH_CACHE *)BBEP_PSRAM_MALLOC(iSize);
+    if (pCache == NULL) return BBEP_ERROR_NO_MEMORY;
+    memset(pCache, 0, sizeof(BBEP_GLYPH_CACHE) + iGlyphs * sizeof(BBEP_GLYPH_SLOT));
+    pCache->iCount = iGlyphs;
+    pCache->iSlotSize = iMaxGlyphBytes;
+    pCache->pSlots = (BBEP_GLYPH_SLOT *)&pCache[1];
+    pCache->pBits = (uint8_t *)&pCache->pSlots[iGlyphs];
+    pBBEP->pGlyphCache = pCache;
+    return BBEP_SUCCESS;
+} /* bbepSetGlyphCache() */
+//
+// Return the number of glyph lookups found in / missing from the cache
+//
+void bbepGetGlyphCacheStats(BBEPDISP *pBBEP, uint32_t *pHits, uint32_t *pMisses)
+{
+    BBEP_GLYPH_CACHE *pCache = (pBBEP) ? pBBEP->pGlyphCache : NULL;
+
+    if (pHits) *pHits = (pCache) ? pCache->u32Hits : 0;
+    if (pMisses) *pMisses = (pCache) ? pCache->u32Misses : 0;
+} /* bbepGetGlyphCacheStats() */
+//
+// Return the decoded rows of a glyph (pitch = (w+7)/8), decoding it into
+// the least recently used slot if it isn't cached yet
+// Returns NULL if there is no cache, the glyph doesn't fit or won't decode
+//
+static uint8_t *bbepGlyphCacheGet(BBEPDISP *pBBEP, const void *pFont, int iGlyph, int w, int h, uint8_t *pData, int iDataSize)
+{
+    BBEP_GLYPH_CACHE *pCache = pBBEP->pGlyphCache;
+    BBEP_GLYPH_SLOT *pSlot, *pOldest;
+    uint8_t *pBits;
+    int i, iPitch = (w+7)>>3;
+
+    if (pCache == NULL) return NULL;
+    pCache->u32Clock++;
+    pOldest = pCache->pSlots;
+    for (i=0; i<pCache->iCount; i++) {
+        pSlot = &pCache->pSlots[i];
+        if (pSlot->u32LastUse && pSlot->pFont == pFont && pSlot->u16Glyph == iGlyph) {
+            pSlot->u32LastUse = pCache->u32Clock;
+            pCache->u32Hits++;
+            return &pCache->pBits[i * pCache->iSlotSize];
+        }
+        if (pSlot->u32LastUse < pOldest->u32LastUse) pOldest = pSlot;
+    }
+    pCache->u32Misses++;
+    if (iPitch * h > pCache->iSlotSize) return NULL; // too big to keep
+    if (g5_decode_init(&g5dec, w, h, pData, iDataSize) != G5_SUCCESS) return NULL;
+    pOldest->u32LastUse = 0; // empty while it's being filled
+    pBits = &pCache->pBits[(pOldest - pCache->pSlots) * pCache->iSlotSize];
+    for (i=0; i<h; i++) {
+        // the decoder may touch 1 byte past the row, so don't decode in place
+        int rc = g5_decode_line(&g5dec, u8Cache);
+        if (rc != G5_SUCCESS && rc != G5_DECODE_COMPLETE) return NULL;
+        memcpy(&pBits[i * iPitch], u8Cache, iPitch);
+    }
+    pOldest->pFont = pFont;
+    pOldest->u16Glyph = (uint16_t)iGlyph;
+    pOldest->w = (uint16_t)w;
+    pOldest->h = (uint16_t)h;
+    pOldest->u32LastUse = pCache->u32Clock;
+    return pBits;
+} /* bbepGlyphCacheGet() */
 //
 // Draw a string of BB_FONT characters directly into the EPD framebuffer
 //
 int bbepWriteStringCustom(BBEPDISP *pBBEP, void *pFont, int x, int y, char *szMsg, int iColor, uint8_t iPlane)
 {
-    int rc, i, h, w, j, end_y, dx, dy, tx, ty, tw, iSrcPitch, iPitch, iBG;
+    int rc = G5_SUCCESS, i, h, w, j, end_y, dx, dy, ty, tw, iSrcPitch, iPitch, iBG, iGlyphH;
     signed int n;
     unsigned int c, bInvert = 0;
-    uint8_t *s, uc0, uc1;
+    uint8_t *s, *pRows, uc0, uc1;
     BB_FONT *pBBF;
     BB_FONT_SMALL *pBBFS;
     BB_GLYPH *pGlyph;
@@ -1098,6 +1609,11 @@ int bbepWriteStringCustom(BBEPDISP *pBBEP, void *pFont, int x, int y, char *szMs
     uint8_t *pBits, u8CMD1, u8CMD2, u8CMD, u8EndMask;
     uint8_t szExtMsg[256]; // translated extended ASCII message text
     uint8_t first, last;
+#ifndef NO_RAM
+    BBEP_RUN_FILL rf;
+    int bRuns = 0;
+    int16_t *pFlips;
+#endif
     
     if (pBBEP == NULL) return BBEP_ERROR_BAD_PARAMETER;
     if (pFont == NULL) {
@@ -1126,6 +1642,11 @@ int bbepWriteStringCustom(BBEPDISP *pBBEP, void *pFont, int x, int y, char *szMs
     if (iBG != BBEP_TRANSPARENT) {
         iBG = pBBEP->pColorLookup[iBG & 0xf];
     }
+#ifndef NO_RAM
+    if (pBBEP->ucScreen) { // uncached glyphs on 1-bpp planes are drawn as runs
+        bRuns = bbepRunFillInit(pBBEP, &rf, iColor, iBG);
+    }
+#endif
     if (x == -1)
         x = pBBEP->iCursorX;
     if (y == -1)
@@ -1206,6 +1727,7 @@ int bbepWriteStringCustom(BBEPDISP *pBBEP, void *pFont, int x, int y, char *szMs
                 if (-n < w) dx -= (w+n); // since we draw from the baseline
                 dy = y + xOffset;
             }
+            iGlyphH = h;
             if ((dy + h) > pBBEP->height) { // trim it
                 h = pBBEP->height - dy;
             }
@@ -1220,37 +1742,37 @@ int bbepWriteStringCustom(BBEPDISP *pBBEP, void *pFont, int x, int y, char *szMs
                 ty = (pgm_read_word(&pSmallGlyph[1].bitmapOffset) - (intptr_t)(s - pBits)); // compressed size
             }
             if (ty < 0 || ty > 4096) ty = 4096; // DEBUG
-            rc = g5_decode_init(&g5dec, w, h, s, ty);
-            if (rc != G5_SUCCESS) {
-                pBBEP->last_error = BBEP_ERROR_BAD_DATA;
-                 return BBEP_ERROR_BAD_DATA; // corrupt data?
+            pRows = NULL;
+            if (pBBEP->ucScreen) { // use the already decoded rows if they're cached
+                pRows = bbepGlyphCacheGet(pBBEP, pFont, c, w, iGlyphH, s, ty);
+            }
+            if (pRows == NULL) {
+                rc = g5_decode_init(&g5dec, w, h, s, ty);
+                if (rc != G5_SUCCESS) {
+                    pBBEP->last_error = BBEP_ERROR_BAD_DATA;
+                     return BBEP_ERROR_BAD_DATA; // corrupt data?
+                }
             }
             if (pBBEP->ucScreen) { // backbuffer, draw pixels
 #ifndef NO_RAM
                 tw = w;
                 if (x+tw > pBBEP->width) tw = pBBEP->width - x; // clip to right edge
+                bbepMarkDirty(pBBEP, x, dy, x+tw-1, end_y-1);
                 for (ty=dy; ty<end_y && ty < pBBEP->height; ty++) {
-                    uint8_t u8, u8Count;
-                    g5_decode_line(&g5dec, u8Cache);
-                    s = u8Cache;
-                    u8 = *s++;
-                    u8Count = 8;
-                    if (ty >= 0) {
-                        for (tx=x; tx<x+tw; tx++) {
-                            if (u8 & 0x80) {
-                                if (iColor != BBEP_TRANSPARENT) {
-                                    (*pBBEP->pfnSetPixelFast)(pBBEP, tx, ty, iColor);
-                                }
-                            } else if (iBG != BBEP_TRANSPARENT) {
-                                (*pBBEP->pfnSetPixelFast)(pBBEP, tx, ty, iBG);
-                            }
-                            u8 <<= 1;
-                            u8Count--;
-                            if (u8Count == 0) {
-                                u8Count = 8;
-                                u8 = *s++;
-                            }
+                    if (pRows) {
+                        s = &pRows[(ty - dy) * ((w+7)>>3)];
+                    } else if (bRuns && x >= 0) {
+                        g5_decode_flips(&g5dec, &pFlips);
+                        if (ty >= 0 && pFlips) {
+                            bbepRunFillLine(&rf, pFlips, w, x, ty, tw);
                         }
+                        continue;
+                    } else {
+                        g5_decode_line(&g5dec, u8Cache);
+                        s = u8Cache;
+                    }
+                    if (ty >= 0) {
+                        (*pBBEP->pfnBlitRow)(pBBEP, s, 0x80, 65536, x, ty, tw, iColor, iBG);
                     } // on the screen
                 }
 #endif // NO_RAM
@@ -1504,6 +2026,7 @@ int bbepWriteString(BBEPDISP *pBBEP, int x, int y, char *szMsg, int iSize, int i
             } else { // draw in memory
 #ifndef NO_RAM
                 uint8_t *s, u8Mask;
+                bbepMarkDirty(pBBEP, x, y, x+iCount-1, y+iCount-1);
                 if (iCount == 8) {
                     for (int ty=0; ty<8; ty++) {
                         u8Mask = 1<<ty;
@@ -1518,6 +2041,7 @@ int bbepWriteString(BBEPDISP *pBBEP, int x, int y, char *szMsg, int iSize, int i
                         }
                     }
                 } else { // 16x16
+                    u8Temp[8] = 0; // smoothing reads one row past the glyph
                     bbepStretchAndSmooth(u8Temp, u8Cache, 8, 8, 1); // smooth too
                     for (int ty=0; ty<16; ty++) {
                         s = &u8Cache[2*ty];
@@ -1669,18 +2193,19 @@ int bbepWriteString(BBEPDISP *pBBEP, int x, int y, char *szMsg, int iSize, int i
                 bbepSetAddrWindow(pBBEP, pBBEP->native_width-8-pBBEP->iCursorY, pBBEP->iCursorX, 8, iLen);
                 bbepWriteCmd(pBBEP, ucCMD); // write to "new" plane
                 if (iColor == BBEP_BLACK) {
-                    InvertBytes(&u8Temp[6], iLen);
+                    InvertBytes(&u8Temp[6], 12);
                 }
                 bbepWriteData(pBBEP, &u8Temp[6], iLen);
                 bbepSetAddrWindow(pBBEP, pBBEP->native_width-16-pBBEP->iCursorY, pBBEP->iCursorX, 8, iLen);
                 bbepWriteCmd(pBBEP, ucCMD); // write to "new" plane
                 if (iColor == BBEP_BLACK) {
-                    InvertBytes(&u8Temp[18], iLen);
+                    InvertBytes(&u8Temp[18], 12);
                 }
                 bbepWriteData(pBBEP, &u8Temp[18], iLen);
             } else { // write to RAM
 #ifndef NO_RAM
                 uint8_t u8Mask;
+                bbepMarkDirty(pBBEP, x, y, x+iLen-1, y+15);
                 for (int ty=0; ty<8; ty++) {
                     u8Mask = 1<<ty;
                     for (int tx = 0; tx<iLen; tx++) {
@@ -1732,6 +2257,7 @@ int bbepWriteString(BBEPDISP *pBBEP, int x, int y, char *szMsg, int iSize, int i
             } else { // write to RAM
 #ifndef NO_RAM
                 uint8_t u8Mask;
+                bbepMarkDirty(pBBEP, x, y, x+iLen-1, y+7);
                 for (int ty=0; ty<8; ty++) {
                     u8Mask = 1<<ty;
                     for (int tx = 0; tx<iLen; tx++) {
@@ -1813,15 +2339,108 @@ int bbepAllocBuffer(BBEPDISP *pBBEP, int bDoubleSize)
     } else {
         pBBEP->ucScreen = (uint8_t *)malloc(iSize);
     }
+#elif defined(BBEP_DMA_WRITE)
+    // DMA-capable RAM lets bbepWriteImage() send the planes in place
+    pBBEP->ucScreen = (uint8_t *)heap_caps_malloc(iSize, MALLOC_CAP_DMA);
+    if (pBBEP->ucScreen == NULL) { // still works, but the data gets copied
+        pBBEP->ucScreen = (uint8_t *)malloc(iSize);
+    }
 #else // not ESP32 or no PSRAM
     pBBEP->ucScreen = (uint8_t *)malloc(iSize);
 #endif // ESP32
     if (pBBEP->ucScreen != NULL) {
+        bbepMarkDirty(pBBEP, 0, 0, pBBEP->width-1, pBBEP->height-1); // unknown contents
         return BBEP_SUCCESS;
     }
 #endif
     return BBEP_ERROR_NO_MEMORY; // failed
 } /* bbepAllocBuffer() */
+#ifndef NO_RAM
+//
+// Fill a rectangle of packed pixels (1, 2 or 4 bpp, MSB first) in one
+// plane with a repeated byte pattern. The edge masks are computed once;
+// the whole bytes of each row are written a 32-bit word at a time
+// Coordinates must be ordered and already clipped
+//
+static void bbepFillPlaneRect(uint8_t *pPlane, int iPitch, int x1, int y1, int x2, int y2, int iBpp, uint8_t u8Pattern)
+{
+    int iShift, iFirst, iLast, iCount, ty;
+    uint8_t u8Left, u8Right, *d;
+    uint32_t u32Pattern;
+
+    iShift = (iBpp == 1) ? 3 : (iBpp == 2) ? 2 : 1; // log2(pixels per byte)
+    iFirst = x1 >> iShift;
+    iLast = x2 >> iShift;
+    u8Left = (uint8_t)(0xff >> ((x1 & ((1 << iShift)-1)) * iBpp)); // x1 to end of its byte
+    u8Right = (uint8_t)(0xff << ((((1 << iShift)-1) - (x2 & ((1 << iShift)-1))) * iBpp)); // start of byte to x2
+    if (iFirst == iLast) { // span fits in a single byte
+        u8Left &= u8Right;
+    }
+    u32Pattern = u8Pattern * 0x01010101u;
+    for (ty=y1; ty<=y2; ty++) {
+        d = &pPlane[ty * iPitch];
+        d[iFirst] = (d[iFirst] & ~u8Left) | (u8Pattern & u8Left);
+        if (iFirst == iLast) continue;
+        d[iLast] = (d[iLast] & ~u8Right) | (u8Pattern & u8Right);
+        d += iFirst+1;
+        iCount = iLast - iFirst - 1; // whole bytes in between
+        while (iCount && ((intptr_t)d & 3)) { // align to a word
+            *d++ = u8Pattern;
+            iCount--;
+        }
+        while (iCount >= 4) {
+            *(uint32_t *)d = u32Pattern;
+            d += 4;
+            iCount -= 4;
+        }
+        while (iCount) {
+            *d++ = u8Pattern;
+            iCount--;
+        }
+    } // for ty
+} /* bbepFillPlaneRect() */
+//
+// Fill a rectangle in the back buffer with whole-row spans instead of
+// individual pixels. The layout is picked from the pixel function the
+// panel uses so the result matches what pfnSetPixelFast would draw
+// Takes a translated color and ordered, clipped coordinates
+//
+static void bbepFillRectBuffer(BBEPDISP *pBBEP, int x1, int y1, int x2, int y2, uint8_t ucColor)
+{
+    int iPitch, iSize;
+    uint8_t *pPlane = pBBEP->ucScreen;
+
+    iPitch = (pBBEP->width+7)>>3;
+    iSize = ((pBBEP->native_width+7)>>3) * pBBEP->native_height;
+    if (pBBEP->pfnSetPixelFast == bbepSetPixelFast2Clr) {
+        if (pBBEP->iPlane == PLANE_1) {
+            pPlane += iSize;
+        }
+        bbepFillPlaneRect(pPlane, iPitch, x1, y1, x2, y2, 1, (ucColor == BBEP_WHITE) ? 0xff : 0x00);
+    } else if (pBBEP->pfnSetPixelFast == bbepSetPixelFast3Clr) {
+        if (ucColor >= BBEP_YELLOW) { // yellow/red has priority
+            bbepFillPlaneRect(&pPlane[iSize], iPitch, x1, y1, x2, y2, 1, 0xff);
+        } else {
+            bbepFillPlaneRect(&pPlane[iSize], iPitch, x1, y1, x2, y2, 1, 0x00);
+            bbepFillPlaneRect(pPlane, iPitch, x1, y1, x2, y2, 1, (ucColor == BBEP_WHITE) ? 0xff : 0x00);
+        }
+    } else if (pBBEP->pfnSetPixelFast == bbepSetPixelFast4Gray) {
+        bbepFillPlaneRect(pPlane, iPitch, x1, y1, x2, y2, 1, (ucColor & 1) ? 0xff : 0x00);
+        bbepFillPlaneRect(&pPlane[iSize], iPitch, x1, y1, x2, y2, 1, (ucColor & 2) ? 0xff : 0x00);
+    } else if (pBBEP->pfnSetPixelFast == bbepSetPixelFast4Clr) {
+        bbepFillPlaneRect(pPlane, (pBBEP->width+3)>>2, x1, y1, x2, y2, 2, (ucColor & 3) * 0x55);
+    } else if (pBBEP->pfnSetPixelFast == bbepSetPixelFast16Clr) {
+        bbepFillPlaneRect(pPlane, pBBEP->width>>1, x1, y1, x2, y2, 4, (ucColor & 0xf) * 0x11);
+    } else { // unknown layout, draw it a pixel at a time
+        int tx, ty;
+        for (ty=y1; ty<=y2; ty++) {
+            for (tx=x1; tx<=x2; tx++) {
+                (*pBBEP->pfnSetPixelFast)(pBBEP, tx, ty, ucColor);
+            }
+        }
+    }
+} /* bbepFillRectBuffer() */
+#endif // NO_RAM
 //
 // Draw a line from x1,y1 to x2,y2 in the given color
 // This function supports both buffered and bufferless drawing
@@ -1833,8 +2452,6 @@ void bbepDrawLine(BBEPDISP *pBBEP, int x1, int y1, int x2, int y2, uint8_t ucCol
     int temp;
     int dx = x2 - x1;
     int dy = y2 - y1;
-    int error;
-    int xinc, yinc;
     
     if (pBBEP == NULL) {
         return;
@@ -1843,62 +2460,21 @@ void bbepDrawLine(BBEPDISP *pBBEP, int x1, int y1, int x2, int y2, uint8_t ucCol
         pBBEP->last_error = BBEP_ERROR_BAD_PARAMETER;
         return;
     }
+    bbepMarkDirty(pBBEP, x1, y1, x2, y2);
     ucColor = pBBEP->pColorLookup[ucColor & 0xf];
-    if(abs(dx) > abs(dy)) {
-        // X major case
-        if(x2 < x1) {
-            dx = -dx;
-            temp = x1;
-            x1 = x2;
-            x2 = temp;
-            temp = y1;
-            y1 = y2;
-            y2 = temp;
-        }
-        
-        dy = (y2 - y1);
-        error = dx >> 1;
-        yinc = 1;
-        if (dy < 0)
-        {
-            dy = -dy;
-            yinc = -1;
-        }
-        for(; x1 <= x2; x1++) {
-            (*pBBEP->pfnSetPixelFast)(pBBEP, x1, y1, ucColor);
-            error -= dy;
-            if (error < 0) {
-                error += dx;
-                y1 += yinc;
-            }
-        } // for x1
-    } else {
-        // Y major case
-        if(y1 > y2) {
-            dy = -dy;
-            temp = x1;
-            x1 = x2;
-            x2 = temp;
-            temp = y1;
-            y1 = y2;
-            y2 = temp;
+#ifndef NO_RAM
+    if (pBBEP->ucScreen && (dx == 0 || dy == 0)) { // horizontal or vertical, draw as a span
+        if (x2 < x1) {
+            temp = x1; x1 = x2; x2 = temp;
         }
-        dx = (x2 - x1);
-        error = dy >> 1;
-        xinc = 1;
-        if (dx < 0) {
-            dx = -dx;
-            xinc = -1;
+        if (y2 < y1) {
+            temp = y1; y1 = y2; y2 = temp;
         }
-        for(; y1 <= y2; y1++) {
-            (*pBBEP->pfnSetPixelFast)(pBBEP, x1, y1, ucColor);
-            error -= dx;
-            if (error < 0) {
-                error += dy;
-                x1 += xinc;
-            }
-        } // for y
-    } // y major case
+        bbepFillRectBuffer(pBBEP, x1, y1, x2, y2, ucColor);
+        return;
+    }
+#endif // NO_RAM
+    (*pBBEP->pfnDrawLine)(pBBEP, x1, y1, x2, y2, ucColor);
 } /* bbepDrawLine() */
 
 //
@@ -1917,58 +2493,112 @@ static void DrawScaledPixel(BBEPDISP *pBBEP, int iCX, int iCY, int x, int y, int
     (*pBBEP->pfnSetPixelFast)(pBBEP, x, y, ucColor);
 } /* DrawScaledPixel() */
 //
-// For drawing filled ellipses
+// For drawing filled ellipses, one span per row centered on iCX
 //
-static void DrawScaledLine(BBEPDISP *pBBEP, int iCX, int iCY, int x, int y, int32_t iXFrac, int32_t iYFrac, uint8_t ucColor)
+static void DrawEllipseSpan(BBEPDISP *pBBEP, int iCX, int iCY, int iRow, int iHalf, uint8_t ucColor)
 {
-    int iLen, x2;
-    
-    if (iXFrac != 0x10000) x = ((x * iXFrac) >> 16);
-    if (iYFrac != 0x10000) y = ((y * iYFrac) >> 16);
-    iLen = x*2;
-    x = iCX - x; y += iCY;
-    x2 = x + iLen;
+    int x, x2, y;
+
+    x = iCX - iHalf; x2 = iCX + iHalf;
+    y = iCY + iRow;
     if (y < 0 || y >= pBBEP->height) {
         pBBEP->last_error = BBEP_ERROR_BAD_PARAMETER;
         return; // completely off the screen
     }
     if (x < 0) x = 0;
     if (x2 >= pBBEP->width) x2 = pBBEP->width-1;
-    bbepDrawLine(pBBEP, x, y, x2, y, ucColor);
-} /* DrawScaledLine() */
+    if (x > x2) {
+        pBBEP->last_error = BBEP_ERROR_BAD_PARAMETER;
+        return; // completely off the screen
+    }
+    // ucColor is already translated; bbepDrawLine() would translate it again
+#ifndef NO_RAM
+    if (pBBEP->ucScreen) {
+        bbepFillRectBuffer(pBBEP, x, y, x2, y, ucColor);
+        return;
+    }
+#endif // NO_RAM
+    (*pBBEP->pfnDrawLine)(pBBEP, x, y, x2, y, ucColor);
+} /* DrawEllipseSpan() */
 //
-// Draw the 8 pixels around the Bresenham circle
-// (scaled to make an ellipse)
+// Collect the widest span of each scaled row. Consecutive circle rows that
+// scale to the same ellipse row are merged, so each row is drawn once
+// pPending holds the row and half width waiting to be drawn (-1 = none)
 //
-static void BresenhamCircle(BBEPDISP *pBBEP, int iCX, int iCY, int x, int y, int32_t iXFrac, int32_t iYFrac, uint8_t ucColor, uint8_t u8Parts, uint8_t bFill)
+static void AddEllipseSpan(BBEPDISP *pBBEP, int iCX, int iCY, int *pPending, int iRow, int iHalf, uint8_t ucColor)
 {
-    if (bFill) // draw a filled ellipse
-    {
-        // for a filled ellipse, draw 4 lines instead of 8 pixels
-        DrawScaledLine(pBBEP, iCX, iCY, x, y, iXFrac, iYFrac, ucColor);
-        DrawScaledLine(pBBEP, iCX, iCY, x, -y, iXFrac, iYFrac, ucColor);
-        DrawScaledLine(pBBEP, iCX, iCY, y, x, iXFrac, iYFrac, ucColor);
-        DrawScaledLine(pBBEP, iCX, iCY, y, -x, iXFrac, iYFrac, ucColor);
+    if (pPending[1] >= 0 && pPending[0] == iRow) {
+        if (iHalf > pPending[1]) pPending[1] = iHalf;
+        return;
     }
-    else // draw 8 pixels around the edges
-    {
-        if (u8Parts & 1) {
-            DrawScaledPixel(pBBEP, iCX, iCY, -x, -y, iXFrac, iYFrac, ucColor);
-            DrawScaledPixel(pBBEP, iCX, iCY, -y, -x, iXFrac, iYFrac, ucColor);
-        }
-        if (u8Parts & 2) {
-            DrawScaledPixel(pBBEP, iCX, iCY, x, -y, iXFrac, iYFrac, ucColor);
-            DrawScaledPixel(pBBEP, iCX, iCY, y, -x, iXFrac, iYFrac, ucColor);
+    if (pPending[1] >= 0) {
+        DrawEllipseSpan(pBBEP, iCX, iCY, pPending[0], pPending[1], ucColor);
+    }
+    pPending[0] = iRow; pPending[1] = iHalf;
+} /* AddEllipseSpan() */
+//
+// Draw a filled ellipse as horizontal spans. The rows and widths are the
+// ones the 4 mirrored lines per Bresenham step used to cover, but the
+// scaling is done once per circle row and each ellipse row is filled once
+//
+static void FillScaledEllipse(BBEPDISP *pBBEP, int iCX, int iCY, int iRadius, int32_t iXFrac, int32_t iYFrac, uint8_t ucColor)
+{
+    int iDelta, x, y, i, bNewY;
+    int iPending[4][2]; // rows from x (below, above), rows from y (below, above)
+
+    for (i=0; i<4; i++) {
+        iPending[i][1] = -1;
+    }
+    iDelta = 3 - (2 * iRadius);
+    x = 0; y = iRadius;
+    while (x <= y) {
+        // circle row x is y wide; it's only visited once
+        i = (y * iXFrac) >> 16;
+        AddEllipseSpan(pBBEP, iCX, iCY, iPending[0], (x * iYFrac) >> 16, i, ucColor);
+        AddEllipseSpan(pBBEP, iCX, iCY, iPending[1], (-x * iYFrac) >> 16, i, ucColor);
+        bNewY = 0;
+        x++;
+        if (iDelta < 0) {
+            iDelta += (4*x) + 6;
+        } else {
+            iDelta += 4 * (x-y) + 10;
+            bNewY = 1;
         }
-        if (u8Parts & 4) {
-            DrawScaledPixel(pBBEP, iCX, iCY, x, y, iXFrac, iYFrac, ucColor);
-            DrawScaledPixel(pBBEP, iCX, iCY, y, x, iXFrac, iYFrac, ucColor);
+        if (bNewY || x > y) { // circle row y is done; its width is the last x
+            i = ((x-1) * iXFrac) >> 16;
+            AddEllipseSpan(pBBEP, iCX, iCY, iPending[2], (y * iYFrac) >> 16, i, ucColor);
+            AddEllipseSpan(pBBEP, iCX, iCY, iPending[3], (-y * iYFrac) >> 16, i, ucColor);
         }
-        if (u8Parts & 8) {
-            DrawScaledPixel(pBBEP, iCX, iCY, -x, y, iXFrac, iYFrac, ucColor);
-            DrawScaledPixel(pBBEP, iCX, iCY, -y, x, iXFrac, iYFrac, ucColor);
+        if (bNewY) y--;
+    }
+    for (i=0; i<4; i++) { // draw what's left
+        if (iPending[i][1] >= 0) {
+            DrawEllipseSpan(pBBEP, iCX, iCY, iPending[i][0], iPending[i][1], ucColor);
         }
     }
+} /* FillScaledEllipse() */
+//
+// Draw the 8 pixels around the Bresenham circle
+// (scaled to make an ellipse)
+//
+static void BresenhamCircle(BBEPDISP *pBBEP, int iCX, int iCY, int x, int y, int32_t iXFrac, int32_t iYFrac, uint8_t ucColor, uint8_t u8Parts)
+{
+    if (u8Parts & 1) {
+        DrawScaledPixel(pBBEP, iCX, iCY, -x, -y, iXFrac, iYFrac, ucColor);
+        DrawScaledPixel(pBBEP, iCX, iCY, -y, -x, iXFrac, iYFrac, ucColor);
+    }
+    if (u8Parts & 2) {
+        DrawScaledPixel(pBBEP, iCX, iCY, x, -y, iXFrac, iYFrac, ucColor);
+        DrawScaledPixel(pBBEP, iCX, iCY, y, -x, iXFrac, iYFrac, ucColor);
+    }
+    if (u8Parts & 4) {
+        DrawScaledPixel(pBBEP, iCX, iCY, x, y, iXFrac, iYFrac, ucColor);
+        DrawScaledPixel(pBBEP, iCX, iCY, y, x, iXFrac, iYFrac, ucColor);
+    }
+    if (u8Parts & 8) {
+        DrawScaledPixel(pBBEP, iCX, iCY, -x, y, iXFrac, iYFrac, ucColor);
+        DrawScaledPixel(pBBEP, iCX, iCY, -y, x, iXFrac, iYFrac, ucColor);
+    }
 } /* BresenhamCircle() */
 
 //
@@ -1989,6 +2619,7 @@ void bbepEllipse(BBEPDISP *pBBEP, int iCenterX, int iCenterY, int32_t iRadiusX,
         pBBEP->last_error = BBEP_ERROR_BAD_PARAMETER;
         return; // invalid radii
     }
+    bbepMarkDirty(pBBEP, iCenterX-iRadiusX, iCenterY-iRadiusY, iCenterX+iRadiusX, iCenterY+iRadiusY);
     ucColor = pBBEP->pColorLookup[ucColor & 0xf];
     if (iRadiusX > iRadiusY) {// use X as the primary radius
         iRadius = iRadiusX;
@@ -1999,10 +2630,14 @@ void bbepEllipse(BBEPDISP *pBBEP, int iCenterX, int iCenterY, int32_t iRadiusX,
         iXFrac = (iRadiusX * 65536) / iRadiusY;
         iYFrac = 65536;
     }
+    if (bFilled) { // u8Parts doesn't apply; the whole ellipse is filled
+        FillScaledEllipse(pBBEP, iCenterX, iCenterY, iRadius, iXFrac, iYFrac, ucColor);
+        return;
+    }
     iDelta = 3 - (2 * iRadius);
     x = 0; y = iRadius;
     while (x <= y) {
-        BresenhamCircle(pBBEP, iCenterX, iCenterY, x, y, iXFrac, iYFrac, ucColor, u8Parts, bFilled);
+        BresenhamCircle(pBBEP, iCenterX, iCenterY, x, y, iXFrac, iYFrac, ucColor, u8Parts);
         x++;
         if (iDelta < 0) {
             iDelta += (4*x) + 6;
@@ -2043,16 +2678,12 @@ void bbepRectangle(BBEPDISP *pBBEP, int x1, int y1, int x2, int y2, uint8_t ucCo
         y1 = y2;
         y2 = tmp;
     }
+    bbepMarkDirty(pBBEP, x1, y1, x2, y2);
     if (bFilled)
     {
 #ifndef NO_RAM
         if (pBBEP->ucScreen) { // has a buffer to fill
-            int tx, ty;
-            for (ty = y1; ty <= y2; ty++) {
-                for (tx = x1; tx <= x2; tx++) {
-                    (*pBBEP->pfnSetPixelFast)(pBBEP, tx, ty, ucColor);
-                }
-            }
+            bbepFillRectBuffer(pBBEP, x1, y1, x2, y2, ucColor);
         } else
 #endif // NO_RAM
         { // no buffer
@@ -2071,15 +2702,10 @@ void bbepRectangle(BBEPDISP *pBBEP, int x1, int y1, int x2, int y2, uint8_t ucCo
     {
 #ifndef NO_RAM
         if (pBBEP->ucScreen) { // has a buffer to fill
-            int tx, ty;
-            for (ty = y1; ty <= y2; ty++) {
-                (*pBBEP->pfnSetPixelFast)(pBBEP, x1, ty, ucColor);
-                (*pBBEP->pfnSetPixelFast)(pBBEP, x2, ty, ucColor);
-            }
-            for (tx = x1; tx <= x2; tx++) {
-                (*pBBEP->pfnSetPixelFast)(pBBEP, tx, y1, ucColor);
-                (*pBBEP->pfnSetPixelFast)(pBBEP, tx, y2, ucColor);
-            }
+            bbepFillRectBuffer(pBBEP, x1, y1, x2, y1, ucColor); // top
+            bbepFillRectBuffer(pBBEP, x1, y2, x2, y2, ucColor); // bottom
+            bbepFillRectBuffer(pBBEP, x1, y1, x1, y2, ucColor); // left
+            bbepFillRectBuffer(pBBEP, x2, y1, x2, y2, ucColor); // right
         }
 #endif
     } // outline
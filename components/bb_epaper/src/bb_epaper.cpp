@@ -32,7 +32,9 @@ void delay(int);
 #endif // __LINUX__
 
 #include "bb_epaper.h"
-#ifdef __LINUX__
+#ifdef BBEP_HEADLESS
+#include "headless_io.inl" // no hardware, virtual displays only
+#elif defined(__LINUX__)
 #include "rpi_io.inl"
 #else
 #ifdef ARDUINO
@@ -100,14 +102,36 @@ int BBEPAPER::writePlane(int iPlane, bool bInvert)
     return rc;
 } /* writePlane() */
 
+int BBEPAPER::writePlaneDirty(int iPlane, bool bInvert)
+{
+    long l = millis();
+    int rc;
+    rc = bbepWritePlaneDirty(&_bbep, iPlane, (int)bInvert);
+    _bbep.iDataTime = (int)(millis() - l);
+    return rc;
+} /* writePlaneDirty() */
+
 int BBEPAPER::refresh(int iMode, bool bWait)
 {
     int rc;
+#ifdef BBEP_BUSY_IRQ
+    if (bbepBusyAsyncPending()) {
+        return BBEP_ERROR_BUSY; // the previous async refresh is still running
+    }
+#endif
     long l = millis();
+    long u = micros();
+    _bbep.iBusyTime = 0;
     rc = bbepRefresh(&_bbep, iMode);
+    _bbep.iCmdTime = (int)(micros() - u) - _bbep.iBusyTime; // command traffic only
     if (rc == BBEP_SUCCESS && bWait) {
         bbepWaitBusy(&_bbep);
     }
+#ifdef BBEP_BUSY_IRQ
+    else if (rc == BBEP_SUCCESS && _bbep.pfnRefreshDone) {
+        rc = bbepWaitBusyAsync(&_bbep); // callback fires when the panel is done
+    }
+#endif
     _bbep.iOpTime = (int)(millis() - l);
     return rc;
 } /* refresh() */
@@ -131,6 +155,7 @@ int BBEPAPER::createVirtual(int iWidth, int iHeight, int iFlags)
 void BBEPAPER::setBuffer(uint8_t *pBuffer)
 {
     _bbep.ucScreen = pBuffer;
+    bbepMarkDirty(&_bbep, 0, 0, _bbep.width-1, _bbep.height-1); // unknown contents
 }
 
 void BBEPAPER::stretchAndSmooth(uint8_t *pSrc, uint8_t *pDest, int w, int h, int iSmoothType)
@@ -166,6 +191,16 @@ void BBEPAPER::freeBuffer(void)
     }
 } /* freeBuffer() */
 
+int BBEPAPER::setGlyphCache(int iGlyphs, int iMaxGlyphBytes)
+{
+    return bbepSetGlyphCache(&_bbep, iGlyphs, iMaxGlyphBytes);
+} /* setGlyphCache() */
+
+void BBEPAPER::getGlyphCacheStats(uint32_t *pHits, uint32_t *pMisses)
+{
+    bbepGetGlyphCacheStats(&_bbep, pHits, pMisses);
+} /* getGlyphCacheStats() */
+
 uint32_t BBEPAPER::capabilities(void)
 {
   return _bbep.iFlags;
@@ -232,6 +267,11 @@ int BBEPAPER::loadG5Image(const uint8_t *pG5, int x, int y, int iFG, int iBG, fl
     return bbepLoadG5(&_bbep, pG5, x, y, iFG, iBG, fScale);
 } /* loadG5Image() */
 
+int BBEPAPER::loadG5Stream(BBEP_READ_CB *pfnRead, void *pUser, int x, int y, int iFG, int iBG, float fScale)
+{
+    return bbepLoadG5Stream(&_bbep, pfnRead, pUser, x, y, iFG, iBG, fScale);
+} /* loadG5Stream() */
+
 int BBEPAPER::loadBMP(const uint8_t *pBMP, int x, int y, int iFG, int iBG)
 {
     return bbepLoadBMP(&_bbep, pBMP, x, y, iFG, iBG);
@@ -472,7 +512,9 @@ static uint8_t u8Unicode0, u8Unicode1;
 
 void BBEPAPER::drawPixel(int16_t x, int16_t y, uint8_t color)
 {
-    (*_bbep.pfnSetPixel)(&_bbep, x, y, color);
+    if ((*_bbep.pfnSetPixel)(&_bbep, x, y, color) == BBEP_SUCCESS) {
+        bbepMarkDirty(&_bbep, x, y, x, y);
+    }
 }
 int16_t BBEPAPER::getCursorX(void)
 {
@@ -500,6 +542,10 @@ int BBEPAPER::opTime(void)
 {
     return _bbep.iOpTime;
 }
+int BBEPAPER::cmdTime(void)
+{
+    return _bbep.iCmdTime;
+}
 int16_t BBEPAPER::width(void)
 {
    return _bbep.width;
@@ -551,6 +597,23 @@ void BBEPAPER::wait(bool bQuick)
 {
     bbepWaitBusy(&_bbep);
 }
+void BBEPAPER::setBusyTimeout(uint32_t u32Millis)
+{
+    _bbep.iTimeout = u32Millis;
+}
+#if !defined(ARDUINO) && !defined(__LINUX__)
+//
+// Have refresh(iMode, false) return right away and call pfnCallback
+// (from a driver task) once the panel finishes updating.
+// Until then refresh() returns BBEP_ERROR_BUSY, and other writes to the
+// panel poll BUSY instead of taking over the driver task's wait.
+//
+void BBEPAPER::setRefreshCallback(BBEP_REFRESH_CB *pfnCallback, void *pUser)
+{
+    _bbep.pfnRefreshDone = pfnCallback;
+    _bbep.pRefreshUser = pUser;
+}
+#endif
 bool BBEPAPER::isBusy(void)
 {
     return bbepIsBusy(&_bbep);
@@ -42,6 +42,7 @@ enum {
     BBEP_ERROR_NOT_SUPPORTED,
     BBEP_ERROR_NO_MEMORY,
     BBEP_ERROR_OUT_OF_BOUNDS,
+    BBEP_ERROR_BUSY,
     BBEP_ERROR_COUNT
 };
 
@@ -382,20 +383,54 @@ enum {
 typedef int (BB_SET_PIXEL)(void *pBBEP, int x, int y, unsigned char color);
 // Fast pixel drawing function pointer (no boundary checking)
 typedef void (BB_SET_PIXEL_FAST)(void *pBBEP, int x, int y, unsigned char color);
+// Line drawing kernel specialized for the pixel format (no boundary checking)
+typedef void (BB_DRAW_LINE)(void *pBBEP, int x1, int y1, int x2, int y2, unsigned char color);
+// Draw cx pixels of a 1-bpp source row, stepping the source by u32Step (16.16)
+typedef void (BB_BLIT_ROW)(void *pBBEP, const uint8_t *pSrc, uint8_t u8SrcMask, uint32_t u32Step, int x, int y, int cx, int iFG, int iBG);
+// Called when an asynchronous refresh finishes
+typedef void (BBEP_REFRESH_CB)(void *pUser);
+// Supplies the next iLen bytes of a streamed image, see bbepLoadG5Stream()
+// Returns the number of bytes read; fewer than iLen marks the end
+typedef int (BBEP_READ_CB)(void *pUser, uint8_t *pBuf, int iLen);
+// RAM window used to stream compressed image data
+#ifndef BBEP_G5_STREAM_BUF
+#define BBEP_G5_STREAM_BUF 256
+#endif
+
+// One decoded glyph in the custom font glyph cache
+typedef struct bbep_glyph_slot_tag
+{
+const void *pFont; // font the glyph came from (its rotation is fixed per font)
+uint32_t u32LastUse; // LRU clock of the last use (0 = empty)
+uint16_t u16Glyph; // glyph index in the font
+uint16_t w, h; // size of the decoded bitmap
+} BBEP_GLYPH_SLOT;
+// LRU cache of decoded custom font glyphs, see bbepSetGlyphCache()
+typedef struct bbep_glyph_cache_tag
+{
+int iCount, iSlotSize; // number of glyphs and bytes of 1-bpp rows per glyph
+uint32_t u32Clock; // incremented on every lookup
+uint32_t u32Hits, u32Misses;
+BBEP_GLYPH_SLOT *pSlots;
+uint8_t *pBits; // iCount * iSlotSize bytes
+} BBEP_GLYPH_CACHE;
 
 typedef struct bbepstruct
 {
 uint8_t wrap, type, chip_type, last_error;
 uint8_t *ucScreen;
 int iCursorX, iCursorY;
+int iDirtyX1, iDirtyY1, iDirtyX2, iDirtyY2; // area drawn since the last plane write (X1 > X2 = clean)
 int width, height, native_width, native_height;
 int iScreenOffset, iOrientation;
 int iFG, iBG; //current color
 int iFont, iFlags;
 void *pFont;
 int iDataTime, iOpTime; // time in milliseconds for data transmission and operation
+int iCmdTime; // time in microseconds to send the refresh command sequence, BUSY waits excluded
+int iBusyTime; // time in microseconds spent in BUSY waits of command sequences
 uint32_t iSpeed;
-uint32_t iTimeout; // for e-paper panels
+uint32_t iTimeout; // BUSY wait limit in milliseconds (0 = default)
 uint8_t iDCPin, iMOSIPin, iCLKPin, iCSPin, iRSTPin, iBUSYPin;
 uint8_t iCS1Pin, iCS2Pin;
 uint8_t x_offset, y_offset; // memory offsets
@@ -406,6 +441,11 @@ const uint8_t *pInitFast; // fast update init sequence
 const uint8_t *pInitPart; // partial update init sequence
 BB_SET_PIXEL *pfnSetPixel;
 BB_SET_PIXEL_FAST *pfnSetPixelFast;
+BB_DRAW_LINE *pfnDrawLine;
+BB_BLIT_ROW *pfnBlitRow;
+BBEP_REFRESH_CB *pfnRefreshDone; // async refresh completion callback
+void *pRefreshUser;
+BBEP_GLYPH_CACHE *pGlyphCache; // decoded custom font glyphs (NULL = off)
 } BBEPDISP;
 
 #ifdef __cplusplus
@@ -443,6 +483,7 @@ class BBEPAPER
     void initIO(int iDC, int iReset, int iBusy, int iCS, int iSPIChannel, uint32_t u32Speed = 8000000);
 #endif
     int writePlane(int iPlane = PLANE_BOTH, bool bInvert = false);
+    int writePlaneDirty(int iPlane = PLANE_BOTH, bool bInvert = false);
     void startWrite(int iPlane);
     void writeData(uint8_t *pData, int iLen);
     void writeCmd(uint8_t u8Cmd);
@@ -452,6 +493,8 @@ class BBEPAPER
     void * getBuffer(void);
     uint8_t * getCache(void);
     void freeBuffer(void);
+    int setGlyphCache(int iGlyphs, int iMaxGlyphBytes = 256);
+    void getGlyphCacheStats(uint32_t *pHits, uint32_t *pMisses);
     uint32_t capabilities();
     void setRotation(int iAngle);
     int getRotation(void);
@@ -470,6 +513,7 @@ class BBEPAPER
     int loadBMP(const uint8_t *pBMP, int x, int y, int iFG, int iBG);
     int loadBMP3(const uint8_t *pBMP, int x, int y);
     int loadG5Image(const uint8_t *pG5, int x, int y, int iFG, int iBG, float fScale = 1.0f);
+    int loadG5Stream(BBEP_READ_CB *pfnRead, void *pUser, int x, int y, int iFG, int iBG, float fScale = 1.0f);
     void setFont(int iFont);
     void setFont(const void *pFont);
     void drawLine(int x1, int y1, int x2, int y2, int iColor);
@@ -483,6 +527,7 @@ class BBEPAPER
 #endif
     int dataTime();
     int opTime();
+    int cmdTime();
     int16_t height(void);
     int16_t width(void);
     void drawCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
@@ -493,6 +538,10 @@ class BBEPAPER
     void sleep(int bDeep);
     void wake(void);
     void wait(bool bQuick = false);
+    void setBusyTimeout(uint32_t u32Millis);
+#if !defined(ARDUINO) && !defined(__LINUX__)
+    void setRefreshCallback(BBEP_REFRESH_CB *pfnCallback, void *pUser);
+#endif
     bool isBusy(void);
     void drawString(const char *pText, int x, int y);
     void setPlane(int iPlane);
@@ -537,5 +586,26 @@ typedef enum
 void bbepWriteCmd(BBEPDISP *pBBEP, uint8_t cmd);
 void bbepWriteData(BBEPDISP *pBBEP, uint8_t *pData, int iLen);
 void bbepCMD2(BBEPDISP *pBBEP, uint8_t cmd1, uint8_t cmd2);
+int bbepSetPanelType(BBEPDISP *pBBEP, int iPanel);
+void bbepSendCMDSequence(BBEPDISP *pBBEP, const uint8_t *pSeq);
+void bbepBeginData(BBEPDISP *pBBEP);
+void bbepEndData(BBEPDISP *pBBEP);
+void bbepMarkDirty(BBEPDISP *pBBEP, int x1, int y1, int x2, int y2);
+int bbepSetGlyphCache(BBEPDISP *pBBEP, int iGlyphs, int iMaxGlyphBytes);
+void bbepGetGlyphCacheStats(BBEPDISP *pBBEP, uint32_t *pHits, uint32_t *pMisses);
+#ifdef BBEP_HEADLESS
+// Stand-in for the SPI link of headless builds, see headless_io.inl
+typedef struct bbep_headless_spi_tag
+{
+int bTimed; // take as long as the bytes would on the bus at iSpeed
+int iCmdSetupUs; // pause before each command byte (D/C setup)
+int iTransUs; // driver cost of each polled transfer (CS, transaction setup)
+int bQueued; // bbepBeginData() bursts keep the bus busy while the CPU runs on
+uint32_t u32Commands, u32DataBytes; // traffic counters
+uint8_t *pCapture; // if set, data bytes are appended here
+int iCaptureSize, iCaptureLen;
+} BBEP_HEADLESS_SPI;
+extern BBEP_HEADLESS_SPI bbepHeadlessSPI;
+#endif // BBEP_HEADLESS
 #endif // __BB_EPAPER__
 
@@ -49,6 +49,13 @@ static const uint8_t code_table[128]  =
          0x11, 3, 0x11, 3, 0x11, 3, 0x11, 3,
          0x11, 3, 0x11, 3, 0x11, 3, 0x11, 3};
 
+// Count the leading 0 bits of a non-zero 32-bit value
+#ifdef __AVR__
+#define G5_CLZ32(u) __builtin_clzl(u)
+#else
+#define G5_CLZ32(u) __builtin_clz(u)
+#endif
+
 static int g5_decode_init(G5DECIMAGE *pImage, int iWidth, int iHeight, uint8_t *pData, int iDataSize)
 {
     if (pImage == NULL || iWidth < 1 || iHeight < 1 || pData == NULL || iDataSize < 1)
@@ -56,6 +63,8 @@ static int g5_decode_init(G5DECIMAGE *pImage, int iWidth, int iHeight, uint8_t *
     
     pImage->iVLCSize = iDataSize;
     pImage->pSrc = pData;
+    pImage->pBufEnd = pImage->pBufLimit = &pData[iDataSize];
+    pImage->pfnRead = NULL;
     pImage->ulBitOff = 0;
     pImage->y = 0;
     pImage->ulBits = TIFFMOTOLONG(pData); // preload the first 32 bits of data
@@ -64,6 +73,61 @@ static int g5_decode_init(G5DECIMAGE *pImage, int iWidth, int iHeight, uint8_t *
     return G5_SUCCESS;
 
 } /* g5_decode_init() */
+//
+// Move the unread data to the start of the stream window and fill the
+// rest of it from the read callback. Returns the new buffer pointer.
+// Data held entirely in memory has nothing to refill.
+//
+static uint8_t *g5_refill(G5DECIMAGE *pPage, uint8_t *pBuf)
+{
+    int iLeft, iLen, iRead;
+
+    if (pPage->pfnRead == NULL) {
+        return pBuf;
+    }
+    if (pPage->iSrcLeft == 0) { // nothing more to read, don't run off the window
+        return (pBuf > pPage->pBufEnd) ? pPage->pBufEnd : pBuf;
+    }
+    iLeft = (int)(pPage->pBufEnd - pBuf);
+    memmove(pPage->pSrc, pBuf, iLeft);
+    iLen = pPage->iWindowSize - 4 - iLeft; // keep room for the zero padding
+    if (iLen > pPage->iSrcLeft) iLen = pPage->iSrcLeft;
+    iRead = (*pPage->pfnRead)(pPage->pUser, &pPage->pSrc[iLeft], iLen);
+    if (iRead < 0) iRead = 0;
+    pPage->iSrcLeft = (iRead < iLen) ? 0 : pPage->iSrcLeft - iRead; // short read = end of data
+    pPage->pBufEnd = &pPage->pSrc[iLeft + iRead];
+    memset(pPage->pBufEnd, 0, 4); // the bit reader loads 4 bytes at a time
+    // refill before a 4 byte load could reach past the data
+    pPage->pBufLimit = (pPage->iSrcLeft) ? pPage->pBufEnd - 4 : pPage->pBufEnd;
+    return pPage->pSrc;
+} /* g5_refill() */
+//
+// Prepare to decode an image which is read in pieces by pfnRead instead
+// of being held in memory. pWindow holds the data not yet decoded and
+// is refilled as it's used; iDataSize is the total compressed size.
+// The image can only be decoded once, from the top.
+//
+static int g5_decode_init_stream(G5DECIMAGE *pImage, int iWidth, int iHeight, G5_READ_CALLBACK *pfnRead, void *pUser, int iDataSize, uint8_t *pWindow, int iWindowSize)
+{
+    if (pImage == NULL || iWidth < 1 || iHeight < 1 || pfnRead == NULL || iDataSize < 1 || pWindow == NULL || iWindowSize < G5_MIN_STREAM_BUF)
+        return G5_INVALID_PARAMETER;
+
+    pImage->iVLCSize = iDataSize;
+    pImage->pSrc = pImage->pBufEnd = pWindow;
+    pImage->pfnRead = pfnRead;
+    pImage->pUser = pUser;
+    pImage->iSrcLeft = iDataSize;
+    pImage->iWindowSize = iWindowSize;
+    g5_refill(pImage, pWindow);
+    if (pImage->pBufEnd == pWindow) // no data
+        return G5_DECODE_ERROR;
+    pImage->ulBitOff = 0;
+    pImage->y = 0;
+    pImage->ulBits = TIFFMOTOLONG(pWindow); // preload the first 32 bits of data
+    pImage->iWidth = iWidth;
+    pImage->iHeight = iHeight;
+    return G5_SUCCESS;
+} /* g5_decode_init_stream() */
 
 static void G5DrawLine(G5DECIMAGE *pPage, int16_t *pCurFlips, uint8_t *pOut)
 {
@@ -160,7 +224,7 @@ static int DecodeLine(G5DECIMAGE *pPage)
     int32_t sCode;
     uint32_t lBits;
     uint32_t ulBits, ulBitOff;
-    uint8_t *pBuf/*, *pBufEnd*/;
+    uint8_t *pBuf, *pBufLimit/*, *pBufEnd*/;
     uint32_t u32HMask, u32HLen; // horizontal code mask and length
 
     pCur = CurFlips = pPage->pCur;
@@ -168,6 +232,7 @@ static int DecodeLine(G5DECIMAGE *pPage)
     ulBits = pPage->ulBits;
     ulBitOff = pPage->ulBitOff;
     pBuf = pPage->pBuf;
+    pBufLimit = pPage->pBufLimit;
     // pBufEnd = &pPage->pSrc[pPage->iVLCSize];
     u32HLen = pPage->iHLen;
     u32HMask = (1 << u32HLen) - 1;
@@ -178,12 +243,20 @@ static int DecodeLine(G5DECIMAGE *pPage)
         if (ulBitOff > (REGISTER_WIDTH-8)) { // need at least 7 unused bits
             pBuf += (ulBitOff >> 3);
             ulBitOff &= 7;
+            if (pBuf > pBufLimit) { // streamed data needs more bytes
+                pBuf = g5_refill(pPage, pBuf);
+                pBufLimit = pPage->pBufLimit;
+            }
             ulBits = TIFFMOTOLONG(pBuf);
         }
         if ((int32_t)(ulBits << ulBitOff) < 0) { /* V(0) code is the most frequent case (1 bit) */
-            a0 = *pRef++;
-            ulBitOff++; // length = 1 bit
-            *pCur++ = a0;
+            // Take the whole run of V(0) codes sitting in the bit buffer at once
+            int iRun = G5_CLZ32(~(ulBits << ulBitOff) | 1); // leading 1 bits
+            do {
+                a0 = *pRef++;
+                ulBitOff++; // length = 1 bit
+                *pCur++ = a0;
+            } while (--iRun && a0 < xsize);
         } else { /* Slower method for the less frequence codes */
             lBits = (ulBits >> ((REGISTER_WIDTH - 8) - ulBitOff)) & 0xfe; /* Only the first 7 bits are useful */
             sCode = code_table[lBits]; /* Get the code type as an 8-bit value */
@@ -224,6 +297,10 @@ static int DecodeLine(G5DECIMAGE *pPage)
                     if (ulBitOff > (REGISTER_WIDTH-16)) { // need at least 16 unused bits
                         pBuf += (ulBitOff >> 3);
                         ulBitOff &= 7;
+                        if (pBuf > pBufLimit) { // streamed data needs more bytes
+                            pBuf = g5_refill(pPage, pBuf);
+                            pBufLimit = pPage->pBufLimit;
+                        }
                         ulBits = TIFFMOTOLONG(pBuf);
                     }
                     a0_p = a0;
@@ -260,6 +337,10 @@ static int DecodeLine(G5DECIMAGE *pPage)
                             if (ulBitOff > (REGISTER_WIDTH-16)) { // need at least 16 unused bits
                                 pBuf += (ulBitOff >> 3);
                                 ulBitOff &= 7;
+                                if (pBuf > pBufLimit) { // streamed data needs more bytes
+                                    pBuf = g5_refill(pPage, pBuf);
+                                    pBufLimit = pPage->pBufLimit;
+                                }
                                 ulBits = TIFFMOTOLONG(pBuf);
                             }
                             tot_run1 = (ulBits >> ((REGISTER_WIDTH - u32HLen) - ulBitOff)) & u32HMask; // get long length
@@ -299,16 +380,20 @@ pilreadg5z:
     return pPage->iError;
 } /* DecodeLine() */
 //
-// Decompress the VLC data
+// Decode the next line as its list of color changes instead of pixels
+// *ppFlips gets pairs of black run start/end x values. The list ends at a
+// run starting at or past the image width or with a zero length run; it
+// stays valid until the next line is decoded (NULL if nothing was decoded)
 //
-static int g5_decode_line(G5DECIMAGE *pPage, uint8_t *pOut)
+static int g5_decode_flips(G5DECIMAGE *pPage, int16_t **ppFlips)
 {
     int rc;
     uint8_t *pBufEnd;
     int16_t *t1;
     
-    if (pPage == NULL || pOut == NULL)
+    if (pPage == NULL || ppFlips == NULL)
         return G5_INVALID_PARAMETER;
+    *ppFlips = NULL;
     if (pPage->y >= pPage->iHeight)
         return G5_DECODE_COMPLETE;
     
@@ -317,7 +402,7 @@ static int g5_decode_line(G5DECIMAGE *pPage, uint8_t *pOut)
     if (pPage->y == 0) { // first time through
         Decode_Begin(pPage);
     }
-    pBufEnd = &pPage->pSrc[pPage->iVLCSize];
+    pBufEnd = pPage->pBufEnd;
     
    if (pPage->pBuf >= pBufEnd) { // read past the end, error
        pPage->iError = G5_DECODE_ERROR;
@@ -325,8 +410,7 @@ static int g5_decode_line(G5DECIMAGE *pPage, uint8_t *pOut)
    }
    rc = DecodeLine(pPage);
    if (rc == G5_SUCCESS) {
-       // Draw the current line
-       G5DrawLine(pPage, pPage->pCur, pOut);
+       *ppFlips = pPage->pCur;
        /*--- Swap current and reference lines ---*/
        t1 = pPage->pRef;
        pPage->pRef = pPage->pCur;
@@ -339,5 +423,20 @@ static int g5_decode_line(G5DECIMAGE *pPage, uint8_t *pOut)
        pPage->iError = rc;
    }
     return pPage->iError;
+} /* g5_decode_flips() */
+//
+// Decompress the VLC data
+//
+static int g5_decode_line(G5DECIMAGE *pPage, uint8_t *pOut)
+{
+    int rc;
+    int16_t *pFlips;
+    
+    if (pPage == NULL || pOut == NULL)
+        return G5_INVALID_PARAMETER;
+    rc = g5_decode_flips(pPage, &pFlips);
+    if (pFlips) { // Draw the current line
+        G5DrawLine(pPage, pFlips, pOut);
+    }
+    return rc;
 } /* Decode() */
-
@@ -0,0 +1,182 @@
+//
+// bb_epaper I/O wrapper functions for builds without any hardware
+// Define BBEP_HEADLESS to draw into virtual displays on a PC, e.g. to
+// render frames to image files or benchmark the drawing code.
+// Commands and data are discarded and there is no BUSY line to wait on.
+// bbepHeadlessSPI counts the traffic, can capture the data bytes and can
+// make each transfer take as long as it would on a real SPI bus, so the
+// cost of command sequences can be measured without a panel.
+// With bQueued set, data between bbepBeginData() and bbepEndData() is
+// timed like the ESP-IDF queued path: it goes out while the caller
+// converts the next rows, at most two 4000-byte staging buffers ahead.
+//
+#ifndef __BB_EP_IO__
+#define __BB_EP_IO__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define INPUT 0
+#define INPUT_PULLUP 1
+#define OUTPUT 2
+#define HIGH 1
+#define LOW 0
+
+#define pgm_read_byte(a) (*(uint8_t *)a)
+#define pgm_read_word(a) (*(uint16_t *)a)
+#define pgm_read_dword(a) (*(uint32_t *)a)
+#define memcpy_P memcpy
+
+// forward references
+void bbepSendCMDSequence(BBEPDISP *pBBEP, const uint8_t *pSeq);
+
+BBEP_HEADLESS_SPI bbepHeadlessSPI;
+static int bHeadlessBurst;
+static long long llHeadlessBusIdle; // when the queued data is all sent (ns)
+
+int digitalRead(int iPin)
+{
+    (void)iPin;
+    return LOW;
+} /* digitalRead() */
+
+void digitalWrite(int iPin, int iState)
+{
+    (void)iPin; (void)iState;
+} /* digitalWrite() */
+
+void pinMode(int iPin, int iMode)
+{
+    (void)iPin; (void)iMode;
+} /* pinMode() */
+
+void delay(int iMS)
+{
+    usleep(iMS * 1000);
+} /* delay() */
+
+long millis(void)
+{
+struct timespec res;
+
+    clock_gettime(CLOCK_MONOTONIC, &res);
+    return (long)(1000L*res.tv_sec + res.tv_nsec/1000000);
+} /* millis() */
+
+long micros(void)
+{
+struct timespec res;
+
+    clock_gettime(CLOCK_MONOTONIC, &res);
+    return (long)(1000000L*res.tv_sec + res.tv_nsec/1000);
+} /* micros() */
+//
+// Keep the pin numbers for reference; the BUSY line is never waited on
+//
+void bbepInitIO(BBEPDISP *pBBEP, uint8_t u8DC, uint8_t u8RST, uint8_t u8BUSY, uint8_t u8CS, uint8_t u8MOSI, uint8_t u8SCK, uint32_t u32Speed)
+{
+    (void)u8BUSY;
+    pBBEP->iDCPin = u8DC;
+    pBBEP->iCSPin = u8CS;
+    pBBEP->iMOSIPin = u8MOSI;
+    pBBEP->iCLKPin = u8SCK;
+    pBBEP->iRSTPin = u8RST;
+    pBBEP->iBUSYPin = 0xff;
+    pBBEP->iSpeed = u32Speed;
+} /* bbepInitIO() */
+
+void bbepSetCS2(BBEPDISP *pBBEP, uint8_t cs)
+{
+    pBBEP->iCS1Pin = pBBEP->iCSPin;
+    pBBEP->iCS2Pin = cs;
+} /* bbepSetCS2() */
+
+static long long bbepHeadlessNanos(void)
+{
+struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+} /* bbepHeadlessNanos() */
+
+static long long bbepHeadlessBitTime(BBEPDISP *pBBEP, long iBits)
+{
+    return (pBBEP->iSpeed) ? iBits * 1000000000LL / pBBEP->iSpeed : 0;
+} /* bbepHeadlessBitTime() */
+//
+// Spin for the time iBits take at the SPI clock plus iExtraUs
+//
+static void bbepHeadlessBusTime(BBEPDISP *pBBEP, long iBits, int iExtraUs)
+{
+long long llEnd;
+
+    llEnd = bbepHeadlessNanos() + iExtraUs * 1000LL + bbepHeadlessBitTime(pBBEP, iBits);
+    while (bbepHeadlessNanos() < llEnd) {
+    }
+} /* bbepHeadlessBusTime() */
+
+void bbepWriteCmd(BBEPDISP *pBBEP, uint8_t cmd)
+{
+    (void)cmd;
+    pBBEP->is_awake = 1; // no reset line to toggle
+    bbepHeadlessSPI.u32Commands++;
+    if (bbepHeadlessSPI.bTimed) {
+        bbepHeadlessBusTime(pBBEP, 8, bbepHeadlessSPI.iCmdSetupUs);
+    }
+} /* bbepWriteCmd() */
+
+void bbepWriteData(BBEPDISP *pBBEP, uint8_t *pData, int iLen)
+{
+    BBEP_HEADLESS_SPI *pSPI = &bbepHeadlessSPI;
+
+    pSPI->u32DataBytes += iLen;
+    if (pSPI->pCapture) {
+        int iCopy = pSPI->iCaptureSize - pSPI->iCaptureLen;
+        if (iCopy > iLen) iCopy = iLen;
+        memcpy(&pSPI->pCapture[pSPI->iCaptureLen], pData, iCopy);
+        pSPI->iCaptureLen += iCopy;
+    }
+    if (pSPI->bTimed && bHeadlessBurst) {
+        long long llNow = bbepHeadlessNanos();
+        if (llHeadlessBusIdle < llNow) llHeadlessBusIdle = llNow;
+        llHeadlessBusIdle += bbepHeadlessBitTime(pBBEP, iLen * 8L);
+        // both staging buffers full: wait for the older one to go out
+        while (llHeadlessBusIdle - bbepHeadlessNanos() > bbepHeadlessBitTime(pBBEP, 2 * 4000 * 8L)) {
+        }
+    } else if (pSPI->bTimed) {
+        bbepHeadlessBusTime(pBBEP, iLen * 8L, pSPI->iTransUs);
+    }
+} /* bbepWriteData() */
+
+void bbepCMD2(BBEPDISP *pBBEP, uint8_t cmd1, uint8_t cmd2)
+{
+    bbepWriteCmd(pBBEP, cmd1);
+    bbepWriteData(pBBEP, &cmd2, 1);
+} /* bbepCMD2() */
+
+void bbepBeginData(BBEPDISP *pBBEP)
+{
+    (void)pBBEP;
+    if (bbepHeadlessSPI.bQueued) {
+        bHeadlessBurst = 1;
+        llHeadlessBusIdle = 0;
+    }
+} /* bbepBeginData() */
+//
+// A burst ends once the last queued byte is on the wire
+//
+void bbepEndData(BBEPDISP *pBBEP)
+{
+    (void)pBBEP;
+    if (bHeadlessBurst) {
+        while (bbepHeadlessNanos() < llHeadlessBusIdle) {
+        }
+        bHeadlessBurst = 0;
+    }
+} /* bbepEndData() */
+
+#endif // __BB_EP_IO__
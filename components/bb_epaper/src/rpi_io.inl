@@ -97,6 +97,14 @@ struct timespec res;
     return (long)iTime;
 } /* millis() */
 
+long micros(void)
+{
+struct timespec res;
+
+    clock_gettime(CLOCK_MONOTONIC, &res);
+    return (long)(1000000L*res.tv_sec + res.tv_nsec/1000);
+} /* micros() */
+
 static void delayMicroseconds(int iMS)
 {
   usleep(iMS);
@@ -180,5 +188,14 @@ void bbepWriteData(BBEPDISP *pBBEP, uint8_t *pData, int iLen)
     SPI_transfer(pBBEP, pData, iLen);
     digitalWrite(pBBEP->iCSPin, HIGH);
 } /* bbepWriteData() */
+//
+// Data bursts are only batched on ESP-IDF; each write here handles CS itself
+//
+void bbepBeginData(BBEPDISP *pBBEP)
+{
+} /* bbepBeginData() */
+void bbepEndData(BBEPDISP *pBBEP)
+{
+} /* bbepEndData() */
 
 #endif // __BB_EP_IO__
@@ -0,0 +1,404 @@
+/**
+ * @file bench.cpp
+ * @brief Time whole frames, the drawing primitives they're made of, Group5 decoding,
+ *        plane writes and the refresh init sequence
+ *
+ * site_bench [-n frames] [-r repeat]
+ *   -n frames  number of synthetic site frames to render (default 2000)
+ *   -r repeat  calls per primitive timing (default 20000)
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <vector>
+
+#include "bb_epaper.h"
+#include "Group5.h"
+#include "gfx_reference.h"
+#include "Roboto_20.h"
+
+extern "C" {
+#include "display.h"
+#include "esp_log.h"
+#include "host_data.h"
+}
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double elapsed_ns(bench_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+}
+
+static void report(const char* name, int calls, double ns)
+{
+    printf("  %-28s %8d calls %12.0f ns/call\n", name, calls, ns / calls);
+}
+
+// Time a primitive called `calls` times; i is the call number
+#define TIME_PRIMITIVE(name, calls, body) \
+    do { \
+        bench_clock::time_point start = bench_clock::now(); \
+        for (int i = 0; i < (calls); i++) { \
+            body; \
+        } \
+        report(name, calls, elapsed_ns(start)); \
+    } while (0)
+
+static void bench_frames(int frames)
+{
+    static site_readings_t readings;
+    double total = 0, min_ns = 1e30, max_ns = 0;
+
+    display_init();
+    for (int i = 0; i < frames; i++) {
+        // Data generation is kept out of the timing
+        host_make_readings(&readings, (uint32_t)i + 1, MAX_READINGS - (i % 4) * 60);
+        host_set_frame(&readings, (uint32_t)i + 1);
+        bench_clock::time_point start = bench_clock::now();
+        display_site_data();
+        double ns = elapsed_ns(start);
+        total += ns;
+        if (ns < min_ns) min_ns = ns;
+        if (ns > max_ns) max_ns = ns;
+    }
+    printf("display_site_data: %d frames, %.3f ms avg, %.3f ms min, %.3f ms max\n",
+           frames, total / frames / 1e6, min_ns / 1e6, max_ns / 1e6);
+
+#ifdef CONFIG_DISPLAY_FRAME_CACHE
+    // Same site and readings again, served from the frame cache
+    bench_clock::time_point start = bench_clock::now();
+    for (int i = 0; i < frames; i++) {
+        display_site_data();
+    }
+    printf("display_site_data cached: %.3f ms avg\n", elapsed_ns(start) / frames / 1e6);
+#endif
+}
+
+static void bench_graphs(int repeat)
+{
+    static site_readings_t readings;
+    bool has_data[MAX_HOURLY_READINGS];
+    float hourly[MAX_HOURLY_READINGS];
+
+    host_make_readings(&readings, 1, MAX_READINGS);
+    for (int i = 0; i < MAX_HOURLY_READINGS; i++) {
+        hourly[i] = readings.temperature[i * 12];
+        has_data[i] = (i % 7) != 3;
+    }
+    printf("display_draw_graph:\n");
+    TIME_PRIMITIVE("line graph, 288 points", repeat / 10,
+        display_draw_graph(5, 114, 388, 80, 0, 10, "Water Temp",
+                           readings.water_temp, readings.count, true, false, NULL));
+    TIME_PRIMITIVE("bar chart, 24 bars", repeat / 10,
+        display_draw_graph(5, 32, 388, 80, -10, 10, "Air Temp",
+                           hourly, MAX_HOURLY_READINGS, true, true, has_data));
+}
+
+static void bench_primitives(int repeat)
+{
+    BBEPAPER epd(EP42B_400x300);
+
+    // Same virtual panel as the host display_init()
+    epd.createVirtual(400, 300, 0);
+    epd.allocBuffer();
+    epd.setTextColor(BBEP_BLACK, BBEP_WHITE);
+
+    printf("primitives (400x300 virtual panel):\n");
+    TIME_PRIMITIVE("fillScreen", repeat / 10, epd.fillScreen(BBEP_WHITE, PLANE_0));
+    epd.setFont(FONT_8x8);
+    TIME_PRIMITIVE("drawString FONT_8x8", repeat,
+        epd.drawString("Max:12.5 Min:-3.0", 9, 38 + (i & 63)));
+    epd.setFont(FONT_12x16);
+    TIME_PRIMITIVE("drawString FONT_12x16", repeat, epd.drawString("12:34", 4, 6 + (i & 63)));
+    epd.setFont(FONT_16x16);
+    TIME_PRIMITIVE("drawString FONT_16x16", repeat,
+        epd.drawString("Chanigund, Ladakh", 64, 6 + (i & 63)));
+    epd.setFont(Roboto_20);
+    epd.setGlyphCache(0);
+    TIME_PRIMITIVE("drawString Roboto_20", repeat, epd.drawString("Chanigund", 64, 30 + (i & 63)));
+    epd.setGlyphCache(64);
+    TIME_PRIMITIVE("drawString Roboto_20 cached", repeat,
+        epd.drawString("Chanigund", 64, 30 + (i & 63)));
+    epd.setGlyphCache(0);
+    TIME_PRIMITIVE("drawLine horizontal", repeat, epd.drawLine(0, 26 + (i & 255), 399, 26 + (i & 255), BBEP_BLACK));
+    TIME_PRIMITIVE("drawLine graph segment", repeat,
+        epd.drawLine(9 + (i % 380), 150 + (i & 15), 10 + (i % 380), 140 + (i & 31), BBEP_BLACK));
+    TIME_PRIMITIVE("drawPixel", repeat, epd.drawPixel(i % 400, (i / 400) % 300, BBEP_BLACK));
+    TIME_PRIMITIVE("drawRect 388x80", repeat, epd.drawRect(5, 32 + (i & 127), 388, 80, BBEP_BLACK));
+    TIME_PRIMITIVE("fillRect 10x30", repeat, epd.fillRect(9 + (i % 380), 60, 10, 30, BBEP_BLACK));
+    TIME_PRIMITIVE("fillCircle r=1", repeat, epd.fillCircle(9 + (i % 380), 150, 1, BBEP_BLACK));
+    TIME_PRIMITIVE("fillCircle r=2", repeat, epd.fillCircle(9 + (i % 380), 150, 2, BBEP_BLACK));
+    TIME_PRIMITIVE("drawCircle r=3", repeat, epd.drawCircle(9 + (i % 380), 150, 3, BBEP_BLACK));
+    // Larger fills against the scaled-line fill they replaced, pixel by pixel
+    TIME_PRIMITIVE("fillCircle r=40", repeat / 10, epd.fillCircle(50 + (i % 300), 150, 40, BBEP_BLACK));
+    TIME_PRIMITIVE("fillCircle r=40 per-pixel", repeat / 10,
+        ref_fill_ellipse(epd, 50 + (i % 300), 150, 40, 40, BBEP_BLACK));
+    TIME_PRIMITIVE("fillEllipse 150x60", repeat / 10,
+        epd.fillEllipse(160 + (i % 80), 150, 150, 60, BBEP_BLACK));
+    TIME_PRIMITIVE("fillEllipse 150x60 per-pixel", repeat / 10,
+        ref_fill_ellipse(epd, 160 + (i % 80), 150, 150, 60, BBEP_BLACK));
+
+    // Plane writes need a real controller type; headless I/O discards the data.
+    // Planes are sized for the native layout, so rotating a 300-line panel
+    // would read past them (38-byte rows x 400); use one with 8-pixel sides
+    BBEPAPER panel(EP37_240x416);
+    panel.initIO(0, 0, 0, 0, 0, 0, 0);
+    panel.allocBuffer();
+    panel.fillScreen(BBEP_WHITE);
+    for (int rotation = 0; rotation < 360; rotation += 90) {
+        char name[32];
+        panel.setRotation(rotation);
+        snprintf(name, sizeof(name), "writePlane rotation %d", rotation);
+        TIME_PRIMITIVE(name, repeat / 100, panel.writePlane(PLANE_BOTH));
+    }
+    panel.freeBuffer();
+    epd.freeBuffer();
+}
+
+// A 394x286 fill (the graph area) as spans and as one drawPixel() per pixel
+static void bench_span_fill(int repeat)
+{
+    static const struct { const char* name; int flags; bool second_plane; } layouts[] = {
+        { "B/W", 0, false },
+        { "3-color", BBEP_3COLOR, true },
+        { "4-color", BBEP_4COLOR, true },
+        { "7-color", BBEP_7COLOR, false },
+    };
+    const int w = 394, h = 286;
+
+    printf("rectangle fill, %dx%d (Mpixels/s):\n", w, h);
+    for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++) {
+        BBEPAPER epd(EP42B_400x300);
+        int calls = repeat / 200;
+
+        epd.createVirtual(400, 300, layouts[l].flags);
+        epd.allocBuffer(layouts[l].second_plane);
+        bench_clock::time_point start = bench_clock::now();
+        for (int i = 0; i < calls * 10; i++) {
+            epd.fillRect(3, 7, w, h, i & 1);
+        }
+        double span_ns = elapsed_ns(start) / 10;
+        start = bench_clock::now();
+        for (int i = 0; i < calls; i++) {
+            for (int y = 7; y < 7 + h; y++) {
+                for (int x = 3; x < 3 + w; x++) {
+                    epd.drawPixel(x, y, i & 1);
+                }
+            }
+        }
+        double pixel_ns = elapsed_ns(start);
+        double pixels = (double)w * h * calls;
+        printf("  %-28s %8.0f span %8.0f per-pixel %6.1fx\n", layouts[l].name,
+               pixels / span_ns * 1e3, pixels / pixel_ns * 1e3, pixel_ns / span_ns);
+        epd.freeBuffer();
+    }
+}
+
+// Compress a 1-bpp image (1 = white) into a BB_BITMAP
+static std::vector<uint8_t> encode_g5(const uint8_t* pixels, int width, int height)
+{
+    int pitch = (width + 7) / 8;
+    std::vector<uint8_t> row(pitch + 8), out(sizeof(BB_BITMAP) + pitch * height + 64);
+    G5ENCODER enc;
+
+    enc.init(width, height, &out[sizeof(BB_BITMAP)], (int)out.size() - (int)sizeof(BB_BITMAP));
+    for (int y = 0; y < height; y++) {
+        memcpy(row.data(), &pixels[y * pitch], pitch);  // the encoder reads past the row
+        enc.encodeLine(row.data());
+    }
+    BB_BITMAP* header = (BB_BITMAP*)out.data();
+    header->u16Marker = BB_BITMAP_MARKER;
+    header->width = (uint16_t)width;
+    header->height = (uint16_t)height;
+    header->size = (uint16_t)enc.size();
+    out.resize(sizeof(BB_BITMAP) + enc.size() + 8);  // decoder reads up to 4 bytes ahead
+    return out;
+}
+
+// Decode every line either to pixels or only to its list of color changes
+static void decode_g5(uint8_t* data, int size, int width, int height, bool runs)
+{
+    static uint8_t row[1024];
+    int16_t* flips;
+    G5DECODER dec;
+
+    dec.init(width, height, data, size);
+    for (int y = 0; y < height; y++) {
+        if (runs) {
+            dec.decodeFlips(&flips);
+        } else {
+            dec.decodeLine(row);
+        }
+    }
+}
+
+// Stream an in-memory BB_BITMAP to loadG5Stream() as if read from a file
+struct g5_stream {
+    const uint8_t* data;
+    int left;
+};
+
+static int read_g5_stream(void* user, uint8_t* buf, int len)
+{
+    g5_stream* stream = (g5_stream*)user;
+    if (len > stream->left) len = stream->left;
+    memcpy(buf, stream->data, len);
+    stream->data += len;
+    stream->left -= len;
+    return len;
+}
+
+static void load_g5_stream(BBEPAPER& epd, const std::vector<uint8_t>& image)
+{
+    g5_stream stream = { image.data(), (int)image.size() };
+    epd.loadG5Stream(read_g5_stream, &stream, 0, 0, BBEP_WHITE, BBEP_BLACK);
+}
+
+static void bench_group5(int repeat)
+{
+    int width, height;
+    const uint8_t* frame = display_get_frame(&width, &height);
+    std::vector<uint8_t> image = encode_g5(frame, width, height);
+    uint8_t* bits = &image[sizeof(BB_BITMAP)];
+    int size = ((BB_BITMAP*)image.data())->size;
+    BBEPAPER epd(EP42B_400x300);
+
+    epd.createVirtual(width, height, 0);
+    epd.allocBuffer();
+    printf("group5, last site frame (%d bytes):\n", size);
+    TIME_PRIMITIVE("decode to rows", repeat / 20, decode_g5(bits, size, width, height, false));
+    TIME_PRIMITIVE("decode to runs", repeat / 20, decode_g5(bits, size, width, height, true));
+    TIME_PRIMITIVE("loadG5Image 1:1 (runs)", repeat / 20,
+        epd.loadG5Image(image.data(), 0, 0, BBEP_WHITE, BBEP_BLACK, 1.0f));
+    TIME_PRIMITIVE("loadG5Stream 1:1 (runs)", repeat / 20, load_g5_stream(epd, image));
+    TIME_PRIMITIVE("loadG5Image x0.9 (rows)", repeat / 20,
+        epd.loadG5Image(image.data(), 0, 0, BBEP_WHITE, BBEP_BLACK, 0.9f));
+    epd.freeBuffer();
+
+    // Every glyph of a font strike, as drawString() decodes them uncached
+    const BB_FONT_SMALL* font = (const BB_FONT_SMALL*)Roboto_20;
+    int glyphs = font->last - font->first;  // the last glyph's size isn't stored
+    uint8_t* font_bits = (uint8_t*)&font->glyphs[glyphs + 1];
+    printf("group5, Roboto_20 strike (%d glyphs):\n", glyphs);
+    for (int pass = 0; pass < 2; pass++) {
+        bench_clock::time_point start = bench_clock::now();
+        for (int i = 0; i < repeat / 20; i++) {
+            for (int g = 0; g < glyphs; g++) {
+                const BB_GLYPH_SMALL* glyph = &font->glyphs[g];
+                if (glyph->width > 1) {
+                    decode_g5(font_bits + glyph->bitmapOffset,
+                              glyph[1].bitmapOffset - glyph->bitmapOffset,
+                              glyph->width, glyph->height, pass == 1);
+                }
+            }
+        }
+        report(pass ? "decode to runs" : "decode to rows", repeat / 20, elapsed_ns(start));
+    }
+}
+
+// One 400x300 plane on a stubbed 10 MHz SPI bus, sent as 300 polled row
+// writes (BBEP_NO_SPI_QUEUE) and as one queued burst. Each polled write
+// also pays POLLED_TRANS_US, an estimate of what spi_device_polling_transmit()
+// and the two CS writes cost on an ESP32; the burst overlaps the row copies
+// with the bus, so its time is close to the 12 ms the bytes take
+#define POLLED_TRANS_US 10
+static void bench_plane_write(int repeat)
+{
+    static const struct { const char* name; int queued; } paths[] = {
+        { "per-row polled writes", 0 },
+        { "queued burst", 1 },
+    };
+    BBEPAPER panel(EP42B_400x300);
+
+    panel.initIO(0, 0, 0, 0, 0, 0, 10000000);
+    panel.allocBuffer();
+    panel.fillScreen(BBEP_WHITE);
+    printf("writePlane EP42B_400x300 (stubbed 10 MHz SPI, %d us per polled write):\n",
+           POLLED_TRANS_US);
+    bbepHeadlessSPI.bTimed = 1;
+    bbepHeadlessSPI.iTransUs = POLLED_TRANS_US;
+    for (size_t p = 0; p < sizeof(paths) / sizeof(paths[0]); p++) {
+        int planes = repeat / 1000;
+
+        bbepHeadlessSPI.bQueued = paths[p].queued;
+        bench_clock::time_point start = bench_clock::now();
+        for (int i = 0; i < planes; i++) {
+            panel.writePlane(PLANE_0);
+        }
+        printf("  %-28s %8d calls %9.1f us/plane, dataTime() %d ms\n", paths[p].name, planes,
+               elapsed_ns(start) / planes / 1e3, panel.dataTime());
+    }
+    bbepHeadlessSPI.bTimed = bbepHeadlessSPI.bQueued = 0;
+    bbepHeadlessSPI.iTransUs = 0;
+    panel.freeBuffer();
+}
+
+// The EP42B full-refresh init sequence (pInitFull) sent on a stubbed 10 MHz
+// SPI bus, as display.cpp sets it up. Once with the delay(1) the ESP-IDF
+// layer used to put before every command, at the ~500 us its nop loop
+// actually takes on an ESP32, and once with the 1 us D/C setup that
+// replaced it. Commands go out one at a time (no BBEP_CMD_LIST queueing)
+#define DELAY1_US 500
+static void bench_init_sequence(int repeat)
+{
+    static const struct { const char* name; int setup_us; } paths[] = {
+        { "delay(1) per command", DELAY1_US },
+        { "1 us command setup", 1 },
+    };
+    BBEPDISP bbep;
+
+    memset(&bbep, 0, sizeof(bbep));
+    bbepSetPanelType(&bbep, EP42B_400x300);
+    bbep.iBUSYPin = 0xff; // as the headless bbepInitIO() leaves it
+    bbep.iSpeed = 10000000;
+    printf("pInitFull command traffic (stubbed 10 MHz SPI, BUSY waits excluded):\n");
+    for (size_t p = 0; p < sizeof(paths) / sizeof(paths[0]); p++) {
+        int sends = repeat / 1000;
+
+        bbepHeadlessSPI.bTimed = 1;
+        bbepHeadlessSPI.iCmdSetupUs = paths[p].setup_us;
+        bbepHeadlessSPI.u32Commands = bbepHeadlessSPI.u32DataBytes = 0;
+        bbep.iBusyTime = 0;
+        bench_clock::time_point start = bench_clock::now();
+        for (int i = 0; i < sends; i++) {
+            bbepSendCMDSequence(&bbep, bbep.pInitFull);
+        }
+        double us = elapsed_ns(start) / 1e3 - bbep.iBusyTime;
+        printf("  %-28s %8d calls %9.1f us/sequence, %u commands + %u data bytes each\n",
+               paths[p].name, sends, us / sends,
+               bbepHeadlessSPI.u32Commands / sends, bbepHeadlessSPI.u32DataBytes / sends);
+    }
+    bbepHeadlessSPI.bTimed = 0;
+    bbepHeadlessSPI.iCmdSetupUs = 0;
+}
+
+int main(int argc, char** argv)
+{
+    int frames = 2000, repeat = 20000, opt;
+
+    while ((opt = getopt(argc, argv, "n:r:")) != -1) {
+        switch (opt) {
+            case 'n': frames = atoi(optarg); break;
+            case 'r': repeat = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n frames] [-r repeat]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (frames < 1) frames = 1;
+    if (repeat < 100) repeat = 100;
+
+    host_log_level = 1;  // per-frame info lines would dominate the timings
+    bench_frames(frames);
+    bench_graphs(repeat);
+    bench_primitives(repeat);
+    bench_span_fill(repeat);
+    bench_group5(repeat);
+    bench_plane_write(repeat);
+    bench_init_sequence(repeat);
+    return 0;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file gfx_reference.h
+ * @brief Pixel-at-a-time versions of bb_epaper fills, for tests and timings
+ */
+
+#ifndef GFX_REFERENCE_H
+#define GFX_REFERENCE_H
+
+#include "bb_epaper.h"
+
+// One row of a filled ellipse as the scaled-line fill drew it: circle
+// point (x, y) scaled, mirrored about the center and clipped to the panel
+static inline void ref_scaled_line(BBEPAPER& epd, int cx, int cy, int x, int y,
+                                   int32_t x_frac, int32_t y_frac, int color)
+{
+    x = (x * x_frac) >> 16;
+    y = cy + ((y * y_frac) >> 16);
+    if (y < 0 || y >= epd.height()) {
+        return;
+    }
+    for (int tx = (cx - x < 0) ? 0 : cx - x; tx <= cx + x && tx < epd.width(); tx++) {
+        epd.drawPixel(tx, y, color);
+    }
+}
+
+// fillEllipse() before it drew spans: four mirrored lines per Bresenham
+// step of a circle of the larger radius, each drawn a pixel at a time
+static inline void ref_fill_ellipse(BBEPAPER& epd, int cx, int cy, int32_t rx, int32_t ry, int color)
+{
+    int32_t x_frac, y_frac;
+    int radius, delta, x, y;
+
+    if (rx > ry) {
+        radius = rx;
+        x_frac = 65536;
+        y_frac = (ry * 65536) / rx;
+    } else {
+        radius = ry;
+        x_frac = (rx * 65536) / ry;
+        y_frac = 65536;
+    }
+    delta = 3 - (2 * radius);
+    x = 0; y = radius;
+    while (x <= y) {
+        ref_scaled_line(epd, cx, cy, x, y, x_frac, y_frac, color);
+        ref_scaled_line(epd, cx, cy, x, -y, x_frac, y_frac, color);
+        ref_scaled_line(epd, cx, cy, y, x, x_frac, y_frac, color);
+        ref_scaled_line(epd, cx, cy, y, -x, x_frac, y_frac, color);
+        x++;
+        if (delta < 0) {
+            delta += (4 * x) + 6;
+        } else {
+            delta += 4 * (x - y) + 10;
+            y--;
+        }
+    }
+}
+
+#endif // GFX_REFERENCE_H
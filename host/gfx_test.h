@@ -0,0 +1,61 @@
+/**
+ * @file gfx_test.h
+ * @brief Random input and buffer layouts shared by the drawing tests
+ *
+ * The tests compare two buffers drawn the same way, so they only need a
+ * repeatable sequence, not a good one: a single LCG seeded with 1.
+ */
+
+#ifndef GFX_TEST_H
+#define GFX_TEST_H
+
+#include <stdint.h>
+
+#include "bb_epaper.h"
+
+static uint32_t s_seed = 1;
+
+static inline uint32_t random_next(void)
+{
+    s_seed = s_seed * 1664525u + 1013904223u;
+    return s_seed;
+}
+
+// 0 to n - 1
+static inline int random_below(int n)
+{
+    return (int)((random_next() >> 8) % (uint32_t)n);
+}
+
+static inline uint8_t random_byte(void)
+{
+    return (uint8_t)(random_next() >> 16);
+}
+
+// Every buffer layout createVirtual() and allocBuffer() can set up
+struct layout {
+    const char* name;
+    int flags;
+    bool second_plane;
+    int plane;
+};
+
+static const layout s_layouts[] = {
+    { "B/W", 0, false, PLANE_0 },
+    { "B/W second plane", 0, true, PLANE_1 },
+    { "3-color", BBEP_3COLOR, true, PLANE_0 },
+    { "4-gray", BBEP_4GRAY, true, PLANE_0 },
+    { "4-color", BBEP_4COLOR, true, PLANE_0 },
+    { "7-color", BBEP_7COLOR, false, PLANE_0 },
+};
+
+// Same sizes as bbepAllocBuffer()
+static inline int buffer_size(const layout& l, int width, int height)
+{
+    if (l.flags & BBEP_7COLOR) {
+        return (width >> 1) * height;
+    }
+    return ((width + 7) >> 3) * height * (l.second_plane ? 2 : 1);
+}
+
+#endif // GFX_TEST_H
@@ -0,0 +1,72 @@
+/**
+ * @file host_data.c
+ * @brief Synthetic site data for the host renderer and benchmark
+ *
+ * Values are built with integer math only, so a seed renders the same
+ * frame on any host and frames can be compared against saved images.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "host_data.h"
+
+// Header strings, defined by main.c on the device
+char g_time_str[16];
+char g_date_str[32];
+
+int host_log_level = 2;
+
+static uint32_t next_random(uint32_t* state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// Random walk in tenths within [lo, hi], drifting toward mid
+static float walk(uint32_t* state, int* value, int lo, int hi)
+{
+    int mid = (lo + hi) / 2;
+    int step = (int)(next_random(state) % 7) - 3;
+
+    if (*value < mid) step++;
+    if (*value > mid) step--;
+    *value += step;
+    if (*value < lo) *value = lo;
+    if (*value > hi) *value = hi;
+    return *value / 10.0f;
+}
+
+void host_make_readings(site_readings_t* readings, uint32_t seed, int count)
+{
+    uint32_t state = seed * 2654435761u + 1;
+    int temp = -40, water = 30, pressure = 8, voltage = 37;
+    int32_t dt = 1760000000 - count * READING_INTERVAL_SEC;
+
+    if (count > MAX_READINGS) count = MAX_READINGS;
+    memset(readings, 0, sizeof(*readings));
+    for (int i = 0; i < count; i++) {
+        dt += READING_INTERVAL_SEC;
+        readings->dt[i] = dt;
+        readings->temperature[i] = walk(&state, &temp, -150, 120);
+        readings->water_temp[i] = walk(&state, &water, 0, 90);
+        readings->pressure[i] = walk(&state, &pressure, 0, 20);
+        readings->voltage[i] = walk(&state, &voltage, 33, 42);
+        readings->counter[i] = i;
+    }
+    readings->count = count;
+}
+
+void host_set_frame(site_readings_t* readings, uint32_t seed)
+{
+    static const char* weekdays[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+    static const char* months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+    g_site_readings = readings;
+    g_site_name = g_site_list[seed % g_num_sites];
+    snprintf(g_time_str, sizeof(g_time_str), "%02u:%02u:00",
+             (unsigned)(seed % 24), (unsigned)(seed * 7 % 60));
+    // Same layout as main.c: "Sun, 23. Nov 2025"
+    snprintf(g_date_str, sizeof(g_date_str), "%s, %02u. %s %04u",
+             weekdays[seed % 7], (unsigned)(seed % 28 + 1), months[seed % 12], 2025u);
+}
@@ -0,0 +1,35 @@
+/**
+ * @file host_data.h
+ * @brief Synthetic site data for the host renderer and benchmark
+ */
+
+#ifndef HOST_DATA_H
+#define HOST_DATA_H
+
+#include <stdint.h>
+#include "site_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Fill a reading history with a repeatable synthetic day
+ * @param readings Destination (oldest first, like the parsed API data)
+ * @param seed Selects the data; the same seed always gives the same frame
+ * @param count Number of readings (at most MAX_READINGS)
+ */
+void host_make_readings(site_readings_t* readings, uint32_t seed, int count);
+
+/**
+ * @brief Point g_site_readings/g_site_name and the header clock at frame data
+ * @param readings History drawn in the graphs
+ * @param seed Selects the site name, time and date shown in the header
+ */
+void host_set_frame(site_readings_t* readings, uint32_t seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_DATA_H
@@ -0,0 +1,51 @@
+/**
+ * @file host_test.h
+ * @brief Minimal checks shared by the host test programs
+ *
+ * Each test is a plain executable run by ctest: CHECK() reports a failed
+ * condition and keeps going, and main() returns HOST_TEST_RESULT().
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int host_test_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            host_test_failures++; \
+        } \
+    } while (0)
+
+#define HOST_TEST_RESULT() (host_test_failures ? 1 : 0)
+
+// Read a whole file into a malloc'd buffer with a NUL after the last byte
+static inline char* host_read_file(const char* path, size_t* len)
+{
+    FILE* f = fopen(path, "rb");
+    char* data = NULL;
+    long size;
+
+    if (f == NULL) {
+        return NULL;
+    }
+    if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0) {
+        data = (char*)malloc(size + 1);
+        if (data != NULL && fread(data, 1, size, f) == (size_t)size) {
+            data[size] = '\0';
+            *len = (size_t)size;
+        } else {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(f);
+    return data;
+}
+
+#endif // HOST_TEST_H
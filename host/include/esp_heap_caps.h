@@ -0,0 +1,17 @@
+/*
+ * Capability-based allocation for host builds: every capability is plain heap
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_DMA     (1 << 3)
+#define MALLOC_CAP_SPIRAM  (1 << 10)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+static inline void* heap_caps_malloc(size_t size, uint32_t caps)
+{
+    (void)caps;
+    return malloc(size);
+}
@@ -0,0 +1,30 @@
+/*
+ * ESP-IDF logging for host builds: messages up to host_log_level go to
+ * stderr. 0 = errors only ... 2 = info (default) ... 4 = verbose.
+ */
+#pragma once
+
+#include <stdio.h>
+
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern int host_log_level;  // defined in host_data.c
+#ifdef __cplusplus
+}
+#endif
+
+#define HOST_LOG(level, letter, tag, format, ...) \
+    do { \
+        if ((level) <= host_log_level) { \
+            fprintf(stderr, letter " (%s) " format "\n", tag, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG(0, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG(1, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HOST_LOG(2, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HOST_LOG(3, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) HOST_LOG(4, "V", tag, format, ##__VA_ARGS__)
@@ -0,0 +1,12 @@
+/*
+ * FreeRTOS types for host builds
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+typedef uint32_t TickType_t;
+
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
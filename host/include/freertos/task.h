@@ -0,0 +1,12 @@
+/*
+ * Task delays for host builds. Rendering doesn't depend on them, so they
+ * return at once to keep frame timings about the drawing code.
+ */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+static inline void vTaskDelay(TickType_t ticks)
+{
+    (void)ticks;
+}
@@ -0,0 +1,19 @@
+/*
+ * Kconfig values for host builds (the defaults from main/Kconfig.projbuild)
+ */
+#pragma once
+
+#define CONFIG_WIFI_SSID "Surya12"
+#define CONFIG_SCREEN_WIDTH 400
+#define CONFIG_SCREEN_HEIGHT 300
+#define CONFIG_DISPLAY_UPDATE_PARTIAL 1
+#define CONFIG_DISPLAY_FULL_REFRESH_EVERY 10
+#define CONFIG_DISPLAY_FULL_REFRESH_MINUTES 30
+#define CONFIG_DISPLAY_FRAME_CACHE 1
+#define CONFIG_EPD_PWR_PIN 7
+#define CONFIG_EPD_BUSY_PIN 48
+#define CONFIG_EPD_RST_PIN 47
+#define CONFIG_EPD_DC_PIN 46
+#define CONFIG_EPD_CS_PIN 45
+#define CONFIG_EPD_SCK_PIN 12
+#define CONFIG_EPD_MOSI_PIN 11
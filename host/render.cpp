@@ -0,0 +1,152 @@
+/**
+ * @file render.cpp
+ * @brief Render the device screens off-device and save or check them
+ *
+ * site_render [-o dir] [-c dir] [-n frames] [-s seed]
+ *   -o dir     write each frame to dir/<name>.pbm (default ".")
+ *   -c dir     compare each frame with dir/<name>.pbm instead of writing;
+ *              exits with 1 if any frame differs or is missing
+ *   -n frames  number of site data frames (default 8)
+ *   -s seed    seed of the first frame (default 1)
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <getopt.h>
+#include <sys/stat.h>
+
+extern "C" {
+#include "display.h"
+#include "host_data.h"
+}
+
+// PBM stores 1 = black; the frame buffer uses 1 = white
+static bool save_pbm(const char* path, const uint8_t* frame, int width, int height)
+{
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        return false;
+    }
+    int pitch = (width + 7) / 8;
+    fprintf(f, "P4\n%d %d\n", width, height);
+    std::vector<uint8_t> row(pitch);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < pitch; x++) {
+            row[x] = ~frame[y * pitch + x];
+        }
+        fwrite(row.data(), 1, pitch, f);
+    }
+    fclose(f);
+    return true;
+}
+
+// Returns the number of differing pixels, or -1 if the file can't be read
+static int compare_pbm(const char* path, const uint8_t* frame, int width, int height)
+{
+    FILE* f = fopen(path, "rb");
+    int w = 0, h = 0, diff = 0;
+
+    if (f == NULL) {
+        return -1;
+    }
+    if (fscanf(f, "P4 %d %d", &w, &h) != 2 || w != width || h != height || fgetc(f) == EOF) {
+        fclose(f);
+        return -1;
+    }
+    int pitch = (width + 7) / 8;
+    std::vector<uint8_t> row(pitch);
+    for (int y = 0; y < height; y++) {
+        if (fread(row.data(), 1, pitch, f) != (size_t)pitch) {
+            fclose(f);
+            return -1;
+        }
+        for (int x = 0; x < pitch; x++) {
+            uint8_t bits = (uint8_t)(row[x] ^ ~frame[y * pitch + x]);
+            if (x == pitch - 1 && (width & 7)) {
+                bits &= (uint8_t)(0xff << (8 - (width & 7)));  // padding bits
+            }
+            diff += __builtin_popcount(bits);
+        }
+    }
+    fclose(f);
+    return diff;
+}
+
+// Save or check the frame now in the buffer; returns false on a mismatch
+static bool output_frame(const char* name, const char* out_dir, const char* check_dir)
+{
+    char path[512];
+    int width, height;
+    const uint8_t* frame = display_get_frame(&width, &height);
+
+    if (frame == NULL) {
+        fprintf(stderr, "%s: no frame buffer\n", name);
+        return false;
+    }
+    if (check_dir) {
+        snprintf(path, sizeof(path), "%s/%s.pbm", check_dir, name);
+        int diff = compare_pbm(path, frame, width, height);
+        if (diff != 0) {
+            if (diff < 0) {
+                printf("%s: missing or unreadable %s\n", name, path);
+            } else {
+                printf("%s: %d pixels differ\n", name, diff);
+            }
+            return false;
+        }
+        return true;
+    }
+    snprintf(path, sizeof(path), "%s/%s.pbm", out_dir, name);
+    if (!save_pbm(path, frame, width, height)) {
+        fprintf(stderr, "Can't write %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    const char* out_dir = ".";
+    const char* check_dir = NULL;
+    int frames = 8;
+    uint32_t seed = 1;
+    int opt, failed = 0;
+    static site_readings_t readings;
+
+    while ((opt = getopt(argc, argv, "o:c:n:s:")) != -1) {
+        switch (opt) {
+            case 'o': out_dir = optarg; break;
+            case 'c': check_dir = optarg; break;
+            case 'n': frames = atoi(optarg); break;
+            case 's': seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-o dir] [-c dir] [-n frames] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if (check_dir == NULL) {
+        mkdir(out_dir, 0755);  // may already exist
+    }
+    display_init();
+    for (int i = 0; i < frames; i++, seed++) {
+        char name[32];
+        // Vary the history length too, partial days leave gaps in the bars
+        host_make_readings(&readings, seed, MAX_READINGS - (int)(seed % 4) * 60);
+        host_set_frame(&readings, seed);
+        display_site_data();
+        snprintf(name, sizeof(name), "site_%u", (unsigned)seed);
+        failed += !output_frame(name, out_dir, check_dir);
+    }
+    display_no_data();
+    failed += !output_frame("no_data", out_dir, check_dir);
+    display_wifi_error();
+    failed += !output_frame("wifi_error", out_dir, check_dir);
+
+    if (check_dir) {
+        printf("%d of %d frames differ\n", failed, frames + 2);
+    }
+    return failed ? 1 : 0;
+}
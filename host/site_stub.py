@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""Local stand-in for the site API, serving a recorded response as JSON or
+in the compact binary format (see main/site_data.h).
+
+  site_stub.py serve fixtures/site_response.json [--port 8080]
+      GET /prod/site?site_name=<name>&count=<n>[&since=<dt>][&format=bin]
+  site_stub.py encode fixtures/site_response.json fixtures/site_response.bin
+      write the binary encoding of the whole response
+"""
+
+import argparse
+import json
+import struct
+import sys
+from http.server import BaseHTTPRequestHandler, HTTPServer
+from urllib.parse import parse_qs, urlparse
+
+MAGIC = b"SDB1"
+VERSION = 2
+DT_ESCAPE = 0xFFFF
+# Quantization per column: temperature, water_temp, pressure, voltage
+SCALES = (100, 100, 1000, 1000)
+COLUMNS = ("temperature", "water_temp", "pressure", "voltage")
+
+
+def quantize(value, scale):
+    if value is None:
+        return 0
+    return max(-32768, min(32767, round(value * scale)))
+
+
+def encode(doc):
+    readings = doc.get("readings", [])
+    current = doc.get("current", {})
+    out = bytearray()
+    out += MAGIC
+    out += struct.pack("<BBH", VERSION, 1 if doc.get("active") else 0, len(readings))
+    out += struct.pack("<ii", doc.get("timezone_offset", 0), doc.get("query_time", 0))
+    out += struct.pack("<4H", *SCALES)
+    out += doc.get("site_type", "").encode()[:16].ljust(16, b"\0")
+    out += doc.get("site_name", "").encode()[:32].ljust(32, b"\0")
+    out += struct.pack("<i", current.get("dt", 0))
+    out += struct.pack("<4h", *(quantize(current.get(c), s) for c, s in zip(COLUMNS, SCALES)))
+    out += struct.pack("<i", current.get("counter", 0))
+
+    # Newest first: the first dt in full, then gaps, escaping long ones
+    for i, r in enumerate(readings):
+        if i == 0:
+            out += struct.pack("<i", r["dt"])
+            continue
+        gap = readings[i - 1]["dt"] - r["dt"]
+        if gap <= 0:
+            raise ValueError("readings must be newest first without duplicates")
+        if gap < DT_ESCAPE:
+            out += struct.pack("<H", gap)
+        else:
+            out += struct.pack("<Hi", DT_ESCAPE, r["dt"])
+    for c, s in zip(COLUMNS, SCALES):
+        out += b"".join(struct.pack("<h", quantize(r.get(c), s)) for r in readings)
+    out += b"".join(struct.pack("<i", r.get("counter", 0)) for r in readings)
+    return bytes(out)
+
+
+def select(doc, site_name, count, since):
+    readings = doc.get("readings", [])
+    if since:
+        readings = [r for r in readings if r["dt"] > since]
+    result = dict(doc, readings=readings[:count])
+    if site_name:
+        result["site_name"] = site_name
+    return result
+
+
+def serve(doc, port):
+    class Handler(BaseHTTPRequestHandler):
+        def do_GET(self):
+            url = urlparse(self.path)
+            if url.path != "/prod/site":
+                self.send_error(404)
+                return
+            query = parse_qs(url.query)
+            arg = lambda name, default: query.get(name, [default])[0]
+            result = select(doc, arg("site_name", ""), int(arg("count", "288")),
+                            int(arg("since", "0")))
+            if arg("format", "") == "bin":
+                body, kind = encode(result), "application/octet-stream"
+            else:
+                body, kind = json.dumps(result).encode(), "application/json"
+            self.send_response(200)
+            self.send_header("Content-Type", kind)
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+
+    print(f"Serving on http://0.0.0.0:{port}/prod/site", file=sys.stderr)
+    HTTPServer(("", port), Handler).serve_forever()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+    p = sub.add_parser("serve")
+    p.add_argument("fixture")
+    p.add_argument("--port", type=int, default=8080)
+    p = sub.add_parser("encode")
+    p.add_argument("fixture")
+    p.add_argument("output")
+    args = parser.parse_args()
+
+    with open(args.fixture) as f:
+        doc = json.load(f)
+    if args.command == "serve":
+        serve(doc, args.port)
+    else:
+        with open(args.output, "wb") as f:
+            f.write(encode(doc))
+
+
+if __name__ == "__main__":
+    main()
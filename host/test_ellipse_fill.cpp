@@ -0,0 +1,72 @@
+/**
+ * @file test_ellipse_fill.cpp
+ * @brief Check the span-based circle and ellipse fill against the scaled-line one
+ *
+ * fillCircle() and fillEllipse() draw one span per row. Over every pair
+ * of radii up to 40, larger ellipses and centers near or past the edges,
+ * they must leave the buffer exactly as the old fill (four mirrored lines
+ * per Bresenham step, see gfx_reference.h) drawn a pixel at a time in
+ * the requested color.
+ */
+
+#include <cstring>
+
+#include "bb_epaper.h"
+#include "gfx_reference.h"
+#include "gfx_test.h"
+#include "host_test.h"
+
+#define WIDTH 160
+#define HEIGHT 120
+
+int main(void)
+{
+    for (const auto& l : s_layouts) {
+        BBEPAPER span(EP42B_400x300), pixel(EP42B_400x300);
+        int size = buffer_size(l, WIDTH, HEIGHT);
+        int cases = 0, failures = host_test_failures;
+
+        span.createVirtual(WIDTH, HEIGHT, l.flags);
+        pixel.createVirtual(WIDTH, HEIGHT, l.flags);
+        span.allocBuffer(l.second_plane);
+        pixel.allocBuffer(l.second_plane);
+        span.setPlane(l.plane);
+        pixel.setPlane(l.plane);
+        uint8_t* a = (uint8_t*)span.getBuffer();
+        uint8_t* b = (uint8_t*)pixel.getBuffer();
+
+        for (int rx = 1; rx <= 200 && host_test_failures == failures; rx++) {
+            for (int ry = 1; ry <= 200; ry++) {
+                // Every pair up to 40, then a sample of the larger ones
+                if ((rx > 40 || ry > 40) && random_below(16) != 0) continue;
+                int cx = random_below(WIDTH), cy = random_below(HEIGHT);
+                int color = random_below(8);
+                if (random_below(4) == 0) { // center near or past an edge
+                    cx = random_below(WIDTH + 2 * rx) - rx;
+                    cy = random_below(HEIGHT + 2 * ry) - ry;
+                }
+                memset(a, 0x5a, size);
+                memset(b, 0x5a, size);
+                if (rx == ry && (cases & 1)) {
+                    span.fillCircle(cx, cy, rx, color);
+                } else {
+                    span.fillEllipse(cx, cy, rx, ry, color);
+                }
+                ref_fill_ellipse(pixel, cx, cy, rx, ry, color);
+                cases++;
+                if (memcmp(a, b, size) != 0) {
+                    fprintf(stderr, "%s: ellipse %dx%d at (%d,%d) color %d differs\n",
+                            l.name, rx, ry, cx, cy, color);
+                    host_test_failures++;
+                    break;
+                }
+            }
+        }
+        if (host_test_failures == failures) {
+            printf("%s: %d filled ellipses match the scaled-line fill\n", l.name, cases);
+        }
+        span.freeBuffer();
+        pixel.freeBuffer();
+    }
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,150 @@
+/**
+ * @file test_site_binary.c
+ * @brief Decode the binary encoding of a recorded response
+ *
+ * test_site_binary <response.json> <response.bin>
+ *
+ * The .bin fixture is the JSON one encoded by site_stub.py; both must
+ * decode to the same site (values within the quantization step), and
+ * damaged copies of the .bin must be rejected without changing the site
+ * metadata or current reading.
+ */
+
+#include <string.h>
+#include <math.h>
+#include "esp_log.h"
+#include "site_data.h"
+#include "host_test.h"
+
+static const float s_step[4] = { 0.01f, 0.01f, 0.001f, 0.001f };  // site_stub.py SCALES
+
+static bool close_to(float a, float b, float step)
+{
+    return fabsf(a - b) <= step / 2 + 1e-6f;
+}
+
+static uint8_t* copy_of(const uint8_t* data, size_t len)
+{
+    uint8_t* copy = (uint8_t*)malloc(len);
+    memcpy(copy, data, len);
+    return copy;
+}
+
+static site_info_t s_shown_info;
+static site_reading_t s_shown_current;
+
+static bool site_unchanged(void)
+{
+    return memcmp(&g_site_info, &s_shown_info, sizeof(s_shown_info)) == 0 &&
+           memcmp(&g_current_reading, &s_shown_current, sizeof(s_shown_current)) == 0;
+}
+
+static void put_i32(uint8_t* p, int32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+int main(int argc, char** argv)
+{
+    static site_readings_t from_json, from_bin;
+    size_t json_len, bin_len;
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <response.json> <response.bin>\n", argv[0]);
+        return 2;
+    }
+    char* json = host_read_file(argv[1], &json_len);
+    uint8_t* bin = (uint8_t*)host_read_file(argv[2], &bin_len);
+    if (json == NULL || bin == NULL) {
+        fprintf(stderr, "Can't read the fixtures\n");
+        return 2;
+    }
+
+    memset(&g_site_info, 0, sizeof(g_site_info));
+    CHECK(parse_site_data(json, &from_json, false));
+    site_info_t json_info = g_site_info;
+    site_reading_t json_current = g_current_reading;
+
+    memset(&g_site_info, 0, sizeof(g_site_info));
+    CHECK(parse_site_data_binary(bin, bin_len, &from_bin, false));
+    CHECK(strcmp(g_site_info.site_name, json_info.site_name) == 0);
+    CHECK(strcmp(g_site_info.site_type, json_info.site_type) == 0);
+    CHECK(g_site_info.active == json_info.active);
+    CHECK(g_site_info.timezone_offset == json_info.timezone_offset);
+    CHECK(g_site_info.query_time == json_info.query_time);
+    CHECK(g_current_reading.dt == json_current.dt);
+    CHECK(g_current_reading.counter == json_current.counter);
+    CHECK(close_to(g_current_reading.temperature, json_current.temperature, s_step[0]));
+    CHECK(close_to(g_current_reading.pressure, json_current.pressure, s_step[2]));
+
+    // The fixture has a gap of two days, which needs an escaped dt
+    bool long_gap = false;
+    CHECK(from_bin.count == from_json.count);
+    for (int i = 0; i < from_json.count && i < from_bin.count; i++) {
+        CHECK(from_bin.dt[i] == from_json.dt[i]);
+        CHECK(from_bin.counter[i] == from_json.counter[i]);
+        CHECK(close_to(from_bin.temperature[i], from_json.temperature[i], s_step[0]));
+        CHECK(close_to(from_bin.water_temp[i], from_json.water_temp[i], s_step[1]));
+        CHECK(close_to(from_bin.pressure[i], from_json.pressure[i], s_step[2]));
+        CHECK(close_to(from_bin.voltage[i], from_json.voltage[i], s_step[3]));
+        if (i > 0 && from_json.dt[i] - from_json.dt[i - 1] > 65535) long_gap = true;
+    }
+    CHECK(long_gap);
+
+    // Find the escaped gap in the dt column
+    int n = bin[6] | (bin[7] << 8);
+    size_t escape = 0;
+    size_t gaps_end = SITE_BIN_HEADER_LEN + 4 + 2 * (size_t)(n - 1);
+    for (size_t off = SITE_BIN_HEADER_LEN + 4; off < gaps_end; off += 2) {
+        if ((bin[off] | (bin[off + 1] << 8)) == SITE_BIN_DT_ESCAPE) {
+            escape = off;
+            break;
+        }
+    }
+    CHECK(escape != 0);
+
+    // A rejected response leaves the site on screen as it was
+    s_shown_info = g_site_info;
+    s_shown_current = g_current_reading;
+    strcpy(s_shown_info.site_name, "Likir");
+    s_shown_current.counter = 7;
+    g_site_info = s_shown_info;
+    g_current_reading = s_shown_current;
+
+    host_log_level = -1;
+    uint8_t* bad;
+
+    // Short by one byte, and cut where the escape's extra bytes are missing
+    CHECK(!parse_site_data_binary(bin, bin_len - 1, &from_bin, false));
+    CHECK(!parse_site_data_binary(bin, SITE_BIN_SIZE(n), &from_bin, false));
+    CHECK(site_unchanged());
+
+    bad = copy_of(bin, bin_len);
+    bad[4] = SITE_BIN_VERSION + 1;
+    CHECK(!parse_site_data_binary(bad, bin_len, &from_bin, false));
+    free(bad);
+
+    // A zero gap is a duplicate reading
+    bad = copy_of(bin, bin_len);
+    bad[SITE_BIN_HEADER_LEN + 4] = 0;
+    bad[SITE_BIN_HEADER_LEN + 5] = 0;
+    CHECK(!parse_site_data_binary(bad, bin_len, &from_bin, false));
+    CHECK(site_unchanged());
+    free(bad);
+
+    // An escaped dt that is not older than the reading before it
+    if (escape != 0) {
+        bad = copy_of(bin, bin_len);
+        put_i32(&bad[escape + 2], json_current.dt + 1);
+        CHECK(!parse_site_data_binary(bad, bin_len, &from_bin, false));
+        CHECK(site_unchanged());
+        free(bad);
+    }
+
+    free(json);
+    free(bin);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,165 @@
+/**
+ * @file test_site_parser.c
+ * @brief Replay a recorded API response through the streaming JSON parser
+ *
+ * test_site_parser <response.json>
+ *
+ * The response is fed in chunks of every size from 1 to 64 bytes, a few
+ * larger sizes and random splits; each run must give exactly the result
+ * of parsing the whole body at once. Truncated and damaged bodies must
+ * fail without touching the site metadata or current reading.
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "site_data.h"
+#include "host_test.h"
+
+typedef struct {
+    site_info_t info;
+    site_reading_t current;
+    site_readings_t readings;
+    bool ok;
+} parse_result_t;
+
+static void reset_globals(void)
+{
+    memset(&g_site_info, 0, sizeof(g_site_info));
+    memset(&g_current_reading, 0, sizeof(g_current_reading));
+}
+
+static void save_result(parse_result_t* result, bool ok)
+{
+    result->info = g_site_info;
+    result->current = g_current_reading;
+    result->ok = ok;
+}
+
+static void parse_whole(const char* json, parse_result_t* result)
+{
+    reset_globals();
+    memset(&result->readings, 0, sizeof(result->readings));
+    bool ok = parse_site_data(json, &result->readings, false);
+    save_result(result, ok);
+}
+
+// chunk > 0 splits evenly, chunk == 0 picks random sizes from *seed
+static void parse_chunked(const char* json, size_t len, size_t chunk, uint32_t* seed,
+                          parse_result_t* result)
+{
+    site_parser_t parser;
+    size_t pos = 0;
+
+    reset_globals();
+    memset(&result->readings, 0, sizeof(result->readings));
+    site_parser_init(&parser, &result->readings);
+    while (pos < len) {
+        size_t n = chunk;
+        if (n == 0) {
+            *seed = *seed * 1664525u + 1013904223u;
+            n = 1 + (*seed >> 16) % 200;
+        }
+        if (n > len - pos) n = len - pos;
+        site_parser_feed(&parser, json + pos, n);
+        pos += n;
+    }
+    save_result(result, site_parser_finish(&parser, false));
+}
+
+static bool same_result(const parse_result_t* a, const parse_result_t* b)
+{
+    return a->ok == b->ok &&
+           memcmp(&a->info, &b->info, sizeof(a->info)) == 0 &&
+           memcmp(&a->current, &b->current, sizeof(a->current)) == 0 &&
+           memcmp(&a->readings, &b->readings, sizeof(a->readings)) == 0;
+}
+
+int main(int argc, char** argv)
+{
+    static parse_result_t whole, chunked;
+    size_t len;
+    uint32_t seed = 1;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <response.json>\n", argv[0]);
+        return 2;
+    }
+    char* json = host_read_file(argv[1], &len);
+    if (json == NULL) {
+        fprintf(stderr, "Can't read %s\n", argv[1]);
+        return 2;
+    }
+
+    // The one-shot parse is the reference, make sure it read the fixture
+    parse_whole(json, &whole);
+    CHECK(whole.ok);
+    CHECK(strcmp(whole.info.site_name, "Sakti") == 0);
+    CHECK(strcmp(whole.info.site_type, "air") == 0);
+    CHECK(whole.info.active);
+    CHECK(whole.info.timezone_offset == 19800);
+    CHECK(whole.current.dt == 1760001200);
+    CHECK(whole.current.temperature == -3.75f);
+    CHECK(whole.current.counter == 5001);
+    CHECK(whole.readings.count == 48);
+    // Oldest first after parsing, the fixture lists newest first
+    CHECK(whole.readings.dt[47] == 1760001200);
+    CHECK(whole.readings.counter[47] == 5000);
+    CHECK(whole.readings.counter[0] == 5000 - 47);
+    for (int i = 1; i < whole.readings.count; i++) {
+        CHECK(whole.readings.dt[i] > whole.readings.dt[i - 1]);
+    }
+
+    for (size_t chunk = 1; chunk <= 64; chunk++) {
+        parse_chunked(json, len, chunk, NULL, &chunked);
+        if (!same_result(&whole, &chunked)) {
+            fprintf(stderr, "%zu-byte chunks differ from the one-shot parse\n", chunk);
+            host_test_failures++;
+        }
+    }
+    static const size_t large[] = { 127, 256, 1000, 4096 };
+    for (size_t i = 0; i < sizeof(large) / sizeof(large[0]); i++) {
+        parse_chunked(json, len, large[i], NULL, &chunked);
+        if (!same_result(&whole, &chunked)) {
+            fprintf(stderr, "%zu-byte chunks differ from the one-shot parse\n", large[i]);
+            host_test_failures++;
+        }
+    }
+    for (int run = 0; run < 100; run++) {
+        parse_chunked(json, len, 0, &seed, &chunked);
+        if (!same_result(&whole, &chunked)) {
+            fprintf(stderr, "random split %d differs from the one-shot parse\n", run);
+            host_test_failures++;
+        }
+    }
+
+    // A body cut short or damaged must not be reported as complete, and
+    // must leave the site on screen as it was
+    site_info_t shown_info = { .site_name = "Likir", .site_type = "drip", .active = false,
+                               .timezone_offset = -3600, .query_time = 42 };
+    site_reading_t shown_current = { .dt = 1700000000, .temperature = 1.5f, .counter = 7 };
+    site_parser_t parser;
+    host_log_level = -1;
+    for (size_t cut = 1; cut < len - 1; cut += 97) {
+        g_site_info = shown_info;
+        g_current_reading = shown_current;
+        site_parser_init(&parser, &chunked.readings);
+        for (size_t pos = 0; pos < cut; pos += 16) {
+            site_parser_feed(&parser, json + pos, (cut - pos < 16) ? cut - pos : 16);
+        }
+        CHECK(!site_parser_finish(&parser, false));
+        CHECK(memcmp(&g_site_info, &shown_info, sizeof(shown_info)) == 0);
+        CHECK(memcmp(&g_current_reading, &shown_current, sizeof(shown_current)) == 0);
+    }
+    char* damaged = (char*)malloc(len + 1);
+    memcpy(damaged, json, len + 1);
+    damaged[len - 3] = '@';  // inside the closing brackets, after every field
+    g_site_info = shown_info;
+    g_current_reading = shown_current;
+    CHECK(!parse_site_data(damaged, &chunked.readings, false));
+    CHECK(memcmp(&g_site_info, &shown_info, sizeof(shown_info)) == 0);
+    CHECK(memcmp(&g_current_reading, &shown_current, sizeof(shown_current)) == 0);
+    free(damaged);
+
+    free(json);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,178 @@
+/**
+ * @file test_site_store.c
+ * @brief Run the flash site cache against a file-backed image
+ *
+ * site_store.c is built with SITE_STORE_BASE_PATH "cache", relative to a
+ * fresh temporary directory, and exercised through snapshots, appends,
+ * damaged records, compaction and an interrupted compaction. Loading a
+ * site rebuilds its state from the file, as after a reboot.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "site_store.h"
+#include "host_data.h"
+#include "host_test.h"
+
+#define SITE 3
+#define READING_BYTES 24  // Six 4-byte columns per reading
+
+static site_readings_t s_readings;   // What the app holds in RAM
+static site_readings_t s_loaded;     // What comes back from flash
+
+static bool same_readings(const site_readings_t* a, const site_readings_t* b)
+{
+    int n = a->count;
+    return n == b->count &&
+           memcmp(a->dt, b->dt, sizeof(a->dt[0]) * n) == 0 &&
+           memcmp(a->temperature, b->temperature, sizeof(a->temperature[0]) * n) == 0 &&
+           memcmp(a->water_temp, b->water_temp, sizeof(a->water_temp[0]) * n) == 0 &&
+           memcmp(a->pressure, b->pressure, sizeof(a->pressure[0]) * n) == 0 &&
+           memcmp(a->voltage, b->voltage, sizeof(a->voltage[0]) * n) == 0 &&
+           memcmp(a->counter, b->counter, sizeof(a->counter[0]) * n) == 0;
+}
+
+static long file_size(const char* path)
+{
+    struct stat st;
+    return (stat(path, &st) == 0) ? (long)st.st_size : -1;
+}
+
+static esp_err_t load(char* time_str, size_t time_len)
+{
+    char date_str[32];
+    memset(&s_loaded, 0xA5, sizeof(s_loaded));
+    return site_store_load(SITE, &s_loaded, time_str, time_len, date_str, sizeof(date_str));
+}
+
+// A fetch that brings `count` readings newer than those held
+static void add_readings(int count, uint32_t seed)
+{
+    static site_readings_t delta;
+    int32_t newest = s_readings.dt[s_readings.count - 1];
+
+    host_make_readings(&delta, seed, count);
+    for (int i = 0; i < count; i++) {
+        delta.dt[i] = newest + (i + 1) * READING_INTERVAL_SEC;
+    }
+    merge_site_readings(&s_readings, &delta, newest, MAX_READINGS);
+}
+
+static void flip_byte(const char* path, long offset)
+{
+    FILE* f = fopen(path, "r+b");
+    fseek(f, offset, SEEK_SET);
+    int c = fgetc(f);
+    fseek(f, offset, SEEK_SET);
+    fputc(c ^ 0x40, f);
+    fclose(f);
+}
+
+int main(void)
+{
+    char dir[] = "/tmp/site_store_XXXXXX";
+    char time_str[16];
+    const char* path = SITE_STORE_BASE_PATH "/site3.dat";
+    const char* tmp_path = SITE_STORE_BASE_PATH "/site3.tmp";
+
+    if (mkdtemp(dir) == NULL || chdir(dir) != 0 || mkdir(SITE_STORE_BASE_PATH, 0755) != 0) {
+        fprintf(stderr, "Can't set up a temporary directory\n");
+        return 2;
+    }
+    host_log_level = 0;
+    CHECK(site_store_init() == ESP_OK);
+
+    // Nothing stored yet
+    CHECK(!site_store_exists(SITE));
+    CHECK(load(time_str, sizeof(time_str)) == ESP_ERR_NOT_FOUND);
+    CHECK(s_loaded.count == 0);
+
+    // Snapshot of a partial day
+    host_make_readings(&s_readings, 7, 200);
+    CHECK(site_store_save(SITE, &s_readings, "10:00:00", "Mon") == ESP_OK);
+    CHECK(site_store_exists(SITE));
+    long snapshot_size = file_size(path);
+    CHECK(snapshot_size > 0);
+    CHECK(load(time_str, sizeof(time_str)) == ESP_OK);
+    CHECK(same_readings(&s_readings, &s_loaded));
+    CHECK(strcmp(time_str, "10:00:00") == 0);
+
+    // Unchanged readings are not written again
+    CHECK(site_store_save(SITE, &s_readings, "10:05:00", "Mon") == ESP_OK);
+    CHECK(file_size(path) == snapshot_size);
+
+    // New readings are appended as a record of their own
+    add_readings(10, 8);
+    CHECK(site_store_save(SITE, &s_readings, "10:50:00", "Mon") == ESP_OK);
+    long append_size = file_size(path) - snapshot_size;
+    CHECK(append_size > 0 && append_size < snapshot_size);
+    CHECK(load(time_str, sizeof(time_str)) == ESP_OK);
+    CHECK(same_readings(&s_readings, &s_loaded));
+    CHECK(strcmp(time_str, "10:50:00") == 0);
+
+    // A damaged last record is dropped and the earlier state loads
+    site_readings_t* before = (site_readings_t*)malloc(sizeof(site_readings_t));
+    *before = s_readings;
+    add_readings(5, 9);
+    CHECK(site_store_save(SITE, &s_readings, "11:15:00", "Mon") == ESP_OK);
+    flip_byte(path, file_size(path) - 10);
+    CHECK(load(time_str, sizeof(time_str)) == ESP_OK);
+    CHECK(same_readings(before, &s_loaded));
+    CHECK(strcmp(time_str, "10:50:00") == 0);
+
+    // The next save rewrites the file as one clean snapshot
+    CHECK(site_store_save(SITE, &s_readings, "11:15:00", "Mon") == ESP_OK);
+    CHECK(file_size(path) == snapshot_size + (s_readings.count - 200) * READING_BYTES);
+    CHECK(load(time_str, sizeof(time_str)) == ESP_OK);
+    CHECK(same_readings(&s_readings, &s_loaded));
+
+    // So is a torn write at the end of the file
+    long clean_size = file_size(path);
+    CHECK(truncate(path, clean_size + 7) == 0);
+    CHECK(load(time_str, sizeof(time_str)) == ESP_OK);
+    CHECK(same_readings(&s_readings, &s_loaded));
+    add_readings(1, 10);
+    CHECK(site_store_save(SITE, &s_readings, "11:20:00", "Mon") == ESP_OK);
+    CHECK(load(time_str, sizeof(time_str)) == ESP_OK);
+    CHECK(same_readings(&s_readings, &s_loaded));
+
+    // A damaged snapshot leaves nothing to load
+    flip_byte(path, 100);
+    CHECK(load(time_str, sizeof(time_str)) == ESP_ERR_NOT_FOUND);
+    CHECK(site_store_save(SITE, &s_readings, "11:20:00", "Mon") == ESP_OK);
+    CHECK(load(time_str, sizeof(time_str)) == ESP_OK);
+    CHECK(same_readings(&s_readings, &s_loaded));
+
+    // Appends grow the file until it is compacted back to one snapshot
+    bool compacted = false;
+    long size = file_size(path);
+    for (int i = 0; i < 1000 && !compacted; i++) {
+        add_readings(1 + i % 3, 11 + i);
+        CHECK(site_store_save(SITE, &s_readings, "12:00:00", "Tue") == ESP_OK);
+        long new_size = file_size(path);
+        compacted = (new_size < size);
+        size = new_size;
+    }
+    CHECK(compacted);
+    CHECK(s_readings.count == MAX_READINGS);
+    CHECK(size == snapshot_size + (MAX_READINGS - 200) * READING_BYTES);
+    CHECK(load(time_str, sizeof(time_str)) == ESP_OK);
+    CHECK(same_readings(&s_readings, &s_loaded));
+
+    // A compaction cut off before its rename is recovered from the .tmp
+    CHECK(rename(path, tmp_path) == 0);
+    CHECK(site_store_exists(SITE));
+    CHECK(load(time_str, sizeof(time_str)) == ESP_OK);
+    CHECK(same_readings(&s_readings, &s_loaded));
+    CHECK(file_size(path) > 0 && file_size(tmp_path) < 0);
+
+    free(before);
+    remove(path);
+    rmdir(SITE_STORE_BASE_PATH);
+    if (chdir("/") == 0) {
+        rmdir(dir);
+    }
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,96 @@
+/**
+ * @file test_span_fill.cpp
+ * @brief Check the span fills against drawing the same pixels one at a time
+ *
+ * fillRect(), drawRect() and horizontal/vertical drawLine() write whole
+ * rows through bbepFillRectBuffer(). For every buffer layout they must
+ * leave exactly the bytes that drawPixel() over the same pixels leaves,
+ * starting from the same random contents.
+ */
+
+#include <cstring>
+#include <utility>
+
+#include "bb_epaper.h"
+#include "gfx_test.h"
+#include "host_test.h"
+
+#define WIDTH 202   // not a multiple of 8 or 32, so rows end mid-byte and unaligned
+#define HEIGHT 61
+
+static void pixel_rect(BBEPAPER& epd, int x1, int y1, int x2, int y2, int color)
+{
+    if (x2 < x1) std::swap(x1, x2);
+    if (y2 < y1) std::swap(y1, y2);
+    for (int y = y1; y <= y2; y++) {
+        for (int x = x1; x <= x2; x++) {
+            epd.drawPixel(x, y, color);
+        }
+    }
+}
+
+int main(void)
+{
+    for (const layout& l : s_layouts) {
+        BBEPAPER span(EP42B_400x300), pixel(EP42B_400x300);
+        int size = buffer_size(l, WIDTH, HEIGHT);
+        int failures = host_test_failures;
+
+        span.createVirtual(WIDTH, HEIGHT, l.flags);
+        pixel.createVirtual(WIDTH, HEIGHT, l.flags);
+        span.allocBuffer(l.second_plane);
+        pixel.allocBuffer(l.second_plane);
+        span.setPlane(l.plane);
+        pixel.setPlane(l.plane);
+        uint8_t* a = (uint8_t*)span.getBuffer();
+        uint8_t* b = (uint8_t*)pixel.getBuffer();
+        for (int i = 0; i < size; i++) {
+            a[i] = b[i] = random_byte();
+        }
+
+        for (int run = 0; run < 2000; run++) {
+            int x1 = random_below(WIDTH), y1 = random_below(HEIGHT);
+            int x2 = random_below(WIDTH), y2 = random_below(HEIGHT);
+            int color = random_below(8);
+            if (run % 4 < 2) { // fillRect() and drawRect() take a size
+                if (x2 < x1) std::swap(x1, x2);
+                if (y2 < y1) std::swap(y1, y2);
+            }
+            switch (run % 4) {
+                case 0: // filled
+                    span.fillRect(x1, y1, x2 - x1 + 1, y2 - y1 + 1, color);
+                    pixel_rect(pixel, x1, y1, x2, y2, color);
+                    break;
+                case 1: // outline
+                    span.drawRect(x1, y1, x2 - x1 + 1, y2 - y1 + 1, color);
+                    pixel_rect(pixel, x1, y1, x2, y1, color);
+                    pixel_rect(pixel, x1, y2, x2, y2, color);
+                    pixel_rect(pixel, x1, y1, x1, y2, color);
+                    pixel_rect(pixel, x2, y1, x2, y2, color);
+                    break;
+                case 2: // horizontal line, either end first, often within one byte
+                    if (run & 4) x2 = x1 + random_below(9) - 4;
+                    if (x2 < 0 || x2 >= WIDTH) x2 = x1;
+                    span.drawLine(x1, y1, x2, y1, color);
+                    pixel_rect(pixel, x1, y1, x2, y1, color);
+                    break;
+                case 3: // vertical line
+                    span.drawLine(x1, y1, x1, y2, color);
+                    pixel_rect(pixel, x1, y1, x1, y2, color);
+                    break;
+            }
+            if (memcmp(a, b, size) != 0) {
+                fprintf(stderr, "%s: buffers differ after drawing %d (%d,%d)-(%d,%d) color %d\n",
+                        l.name, run % 4, x1, y1, x2, y2, color);
+                host_test_failures++;
+                break;
+            }
+        }
+        if (host_test_failures == failures) {
+            printf("%s: span fills match per-pixel drawing\n", l.name);
+        }
+        span.freeBuffer();
+        pixel.freeBuffer();
+    }
+    return HOST_TEST_RESULT();
+}
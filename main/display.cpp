@@ -11,9 +11,12 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include "driver/gpio.h"
 
 #include "bb_epaper.h"
+#include "Group5.h"
 
 // Include bb_epaper fonts
 #include "nicoclean_8.h"
@@ -26,6 +29,9 @@
 extern "C" {
 #include "display.h"
 #include "site_data.h"
+#ifdef CONFIG_DISPLAY_SITE_BACKGROUND
+#include "site_store.h"
+#endif
 #include "lang.h"
 
 // Time and date strings (extern from main.c)
@@ -47,14 +53,41 @@ static const char* TAG = "display";
 #define SCREEN_WIDTH  CONFIG_SCREEN_WIDTH
 #define SCREEN_HEIGHT CONFIG_SCREEN_HEIGHT
 
+#if defined(CONFIG_DISPLAY_UPDATE_PARTIAL)
+#define UPDATE_MODE REFRESH_PARTIAL
+#elif defined(CONFIG_DISPLAY_UPDATE_FAST)
+#define UPDATE_MODE REFRESH_FAST
+#else
+#define UPDATE_MODE REFRESH_FULL
+#endif
+
+#ifndef CONFIG_DISPLAY_UPDATE_FULL
+#define FULL_REFRESH_EVERY   CONFIG_DISPLAY_FULL_REFRESH_EVERY
+#define FULL_REFRESH_US      ((int64_t)CONFIG_DISPLAY_FULL_REFRESH_MINUTES * 60 * 1000000)
+#endif
+
 // Global e-paper display object (C++ class)
 static BBEPAPER* epd = nullptr;
 
+// Refresh policy state. PLANE_1 of the frame buffer holds the frame the
+// panel is showing, which the controller needs for a partial update.
+typedef struct {
+    bool have_previous;         // PLANE_1 matches the panel
+    int updates_since_full;     // Partial/fast refreshes since the last full one
+    int64_t last_full_us;       // esp_timer time of the last full refresh
+    uint32_t full_count;
+    uint32_t fast_count;
+    uint32_t partial_count;
+} refresh_state_t;
+
+static refresh_state_t s_refresh;
+
 // Helper function declarations
 static void draw_heading_section(void);
 static void draw_graph_section(int x, int y);
 static void epd_power_control(bool on);
 static void draw_common_x_axis(int x_pos, int y_pos, int width);
+static void update_display(void);
 
 static void epd_power_control(bool on)
 {
@@ -76,6 +109,75 @@ static void epd_power_control(bool on)
     }
 }
 
+static int choose_refresh_mode(void)
+{
+#ifdef CONFIG_DISPLAY_UPDATE_FULL
+    return REFRESH_FULL;
+#else
+    // Nothing known about what the panel shows (first update after boot)
+    if (!s_refresh.have_previous) {
+        return REFRESH_FULL;
+    }
+    // Clear accumulated ghosting
+    if (s_refresh.updates_since_full >= FULL_REFRESH_EVERY ||
+        esp_timer_get_time() - s_refresh.last_full_us >= FULL_REFRESH_US) {
+        return REFRESH_FULL;
+    }
+    if (UPDATE_MODE == REFRESH_PARTIAL && !epd->hasPartialRefresh()) {
+        return epd->hasFastRefresh() ? REFRESH_FAST : REFRESH_FULL;
+    }
+    if (UPDATE_MODE == REFRESH_FAST && !epd->hasFastRefresh()) {
+        return REFRESH_FULL;
+    }
+    return UPDATE_MODE;
+#endif
+}
+
+// Write the frame in PLANE_0 and refresh the panel as the policy chooses
+static void update_display(void)
+{
+    static const char* mode_names[] = { "full", "fast", "partial" };
+
+    if (epd->getChip() == BBEP_CHIP_NONE) {
+        return;  // Virtual panel (host build), the frame stays in the buffer
+    }
+    int mode = choose_refresh_mode();
+
+    if (mode == REFRESH_PARTIAL) {
+        // New frame to the current RAM, previous frame to the old-image RAM
+        epd->writePlane(PLANE_BOTH);
+    } else {
+        epd->writePlane(PLANE_DUPLICATE);
+    }
+
+    if (epd->refresh(mode, true) != BBEP_SUCCESS) {
+        ESP_LOGW(TAG, "%s refresh failed", mode_names[mode]);
+        s_refresh.have_previous = false;  // Panel contents unknown, go full next time
+        return;
+    }
+
+    // This frame is what the next partial update differs from
+    epd->backupPlane();
+    s_refresh.have_previous = true;
+
+    if (mode == REFRESH_FULL) {
+        s_refresh.full_count++;
+        s_refresh.updates_since_full = 0;
+        s_refresh.last_full_us = esp_timer_get_time();
+    } else {
+        if (mode == REFRESH_FAST) {
+            s_refresh.fast_count++;
+        } else {
+            s_refresh.partial_count++;
+        }
+        s_refresh.updates_since_full++;
+    }
+
+    ESP_LOGI(TAG, "Refresh: %s in %d ms (full %" PRIu32 ", fast %" PRIu32 ", partial %" PRIu32
+             ", %d since full)", mode_names[mode], epd->opTime(), s_refresh.full_count,
+             s_refresh.fast_count, s_refresh.partial_count, s_refresh.updates_since_full);
+}
+
 extern "C" void display_init(void)
 {
     ESP_LOGI(TAG, "Initializing display with bb_epaper");
@@ -83,6 +185,10 @@ extern "C" void display_init(void)
     // Create display object for 4.2" 400x300 e-paper (GDEY042T81)
     epd = new BBEPAPER(EP42B_400x300);
 
+#ifdef DISPLAY_HOST
+    // No panel attached, draw into a virtual B/W display of the same size
+    epd->createVirtual(SCREEN_WIDTH, SCREEN_HEIGHT, 0);
+#else
     // Turn on power to the e-paper display
     epd_power_control(true);
 
@@ -90,6 +196,7 @@ extern "C" void display_init(void)
     ESP_LOGI(TAG, "Initializing EPD I/O...");
     epd->initIO(EPD_DC_PIN, EPD_RST_PIN, EPD_BUSY_PIN, EPD_CS_PIN,
                 EPD_MOSI_PIN, EPD_CLK_PIN, 10000000);
+#endif
 
     // Allocate frame buffer
     ESP_LOGI(TAG, "Allocating buffer...");
@@ -101,6 +208,166 @@ extern "C" void display_init(void)
     ESP_LOGI(TAG, "Display initialized: %dx%d", epd->width(), epd->height());
 }
 
+#ifdef DISPLAY_HOST
+extern "C" const uint8_t* display_get_frame(int* width, int* height)
+{
+    if (epd == nullptr) {
+        return NULL;
+    }
+    *width = epd->width();
+    *height = epd->height();
+    return (const uint8_t*)epd->getBuffer();
+}
+#endif
+
+#ifdef CONFIG_DISPLAY_FRAME_CACHE
+// Finished site screens, Group5 compressed. Each is keyed by a hash of
+// everything the screen is drawn from, so new readings or a new header
+// time simply miss and the screen is drawn (and stored) again.
+typedef struct {
+    uint32_t key;
+    uint8_t* bitmap;   // BB_BITMAP header + compressed data, NULL if empty
+} frame_cache_entry_t;
+
+// Larger than any frame worth keeping (an uncompressed plane is 15 KB)
+#define FRAME_ENCODE_SIZE  (sizeof(BB_BITMAP) + SCREEN_WIDTH / 8 * SCREEN_HEIGHT)
+
+static frame_cache_entry_t* s_frame_cache = nullptr;  // One per g_site_list entry
+static uint8_t* s_frame_encode_buf = nullptr;
+static G5ENCODER s_frame_encoder;
+
+static uint32_t frame_hash(uint32_t hash, const void* data, size_t len)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    while (len--) {
+        hash = (hash ^ *p++) * 16777619u;  // FNV-1a
+    }
+    return hash;
+}
+
+// Hash of the inputs to draw_heading_section() and draw_graph_section()
+static uint32_t frame_key(void)
+{
+    uint32_t hash = 2166136261u;
+    const site_readings_t* readings = g_site_readings;
+
+    hash = frame_hash(hash, g_site_name, strlen(g_site_name));
+    // The header shows only HH:MM, seconds must not miss the cache
+    hash = frame_hash(hash, g_time_str, strnlen(g_time_str, 5));
+    hash = frame_hash(hash, g_date_str, strnlen(g_date_str, sizeof(g_date_str)));
+    if (readings != NULL) {
+        size_t len = readings->count * sizeof(float);
+        hash = frame_hash(hash, &readings->count, sizeof(readings->count));
+        hash = frame_hash(hash, readings->temperature, len);
+        hash = frame_hash(hash, readings->water_temp, len);
+        hash = frame_hash(hash, readings->pressure, len);
+    }
+    return hash;
+}
+
+static frame_cache_entry_t* frame_cache_entry(void)
+{
+    if (s_frame_cache == nullptr) {
+        s_frame_cache = (frame_cache_entry_t*)calloc(g_num_sites, sizeof(frame_cache_entry_t));
+        if (s_frame_cache == nullptr) {
+            return nullptr;
+        }
+    }
+    for (int i = 0; i < g_num_sites; i++) {
+        if (g_site_list[i] == g_site_name || strcmp(g_site_list[i], g_site_name) == 0) {
+            return &s_frame_cache[i];
+        }
+    }
+    return nullptr;
+}
+
+// Decode the site's stored screen into PLANE_0 if it is still current
+static bool frame_cache_load(frame_cache_entry_t* entry, uint32_t key)
+{
+    if (entry == nullptr || entry->bitmap == nullptr || entry->key != key) {
+        return false;
+    }
+    // Every pixel is written, white for 1 bits and black for 0 bits
+    return epd->loadG5Image(entry->bitmap, 0, 0, BBEP_WHITE, BBEP_BLACK) == BBEP_SUCCESS;
+}
+
+// Compress the screen just drawn in PLANE_0 and keep it for the site
+static void frame_cache_store(frame_cache_entry_t* entry, uint32_t key)
+{
+    const int pitch = (SCREEN_WIDTH + 7) / 8;
+    const uint8_t* frame = (const uint8_t*)epd->getBuffer();
+    uint8_t row[(SCREEN_WIDTH + 7) / 8 + 4];  // The encoder reads past the row
+    int rc = G5_SUCCESS;
+
+    if (entry == nullptr) {
+        return;
+    }
+    if (s_frame_encode_buf == nullptr) {
+        s_frame_encode_buf = (uint8_t*)heap_caps_malloc(FRAME_ENCODE_SIZE, MALLOC_CAP_SPIRAM);
+        if (s_frame_encode_buf == nullptr) {
+            return;
+        }
+    }
+    uint8_t* data = s_frame_encode_buf + sizeof(BB_BITMAP);
+    s_frame_encoder.init(SCREEN_WIDTH, SCREEN_HEIGHT, data, FRAME_ENCODE_SIZE - sizeof(BB_BITMAP));
+    memset(row, 0xff, sizeof(row));
+    for (int y = 0; y < SCREEN_HEIGHT && rc == G5_SUCCESS; y++) {
+        memcpy(row, &frame[y * pitch], pitch);
+        rc = s_frame_encoder.encodeLine(row);
+    }
+    free(entry->bitmap);
+    entry->bitmap = nullptr;
+    if (rc != G5_ENCODE_COMPLETE) {
+        ESP_LOGW(TAG, "Screen not cached, compression failed (%d)", rc);
+        return;
+    }
+
+    int size = s_frame_encoder.size();
+    BB_BITMAP* header = (BB_BITMAP*)s_frame_encode_buf;
+    header->u16Marker = BB_BITMAP_MARKER;
+    header->width = SCREEN_WIDTH;
+    header->height = SCREEN_HEIGHT;
+    header->size = (uint16_t)size;
+
+    // The decoder reads up to 4 bytes ahead of the data it uses
+    size_t used = sizeof(BB_BITMAP) + size;
+    entry->bitmap = (uint8_t*)heap_caps_malloc(used + 4, MALLOC_CAP_SPIRAM);
+    if (entry->bitmap == nullptr) {
+        entry->bitmap = (uint8_t*)malloc(used + 4);
+    }
+    if (entry->bitmap != nullptr) {
+        memcpy(entry->bitmap, s_frame_encode_buf, used);
+        memset(entry->bitmap + used, 0, 4);
+        entry->key = key;
+        ESP_LOGD(TAG, "Cached screen for %s: %d bytes", g_site_name, size);
+    }
+}
+#endif // CONFIG_DISPLAY_FRAME_CACHE
+
+#ifdef CONFIG_DISPLAY_SITE_BACKGROUND
+static int background_read(void* user, uint8_t* buf, int len)
+{
+    return (int)fread(buf, 1, len, (FILE*)user);
+}
+
+// Stream the site's background image from SPIFFS, if it has one
+static void draw_site_background(void)
+{
+    char path[32];
+    snprintf(path, sizeof(path), SITE_STORE_BASE_PATH "/bg%d.g5", g_current_site_index);
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        return;
+    }
+    // Only the black pixels are drawn over the white screen
+    int rc = epd->loadG5Stream(background_read, f, 0, 0, BBEP_TRANSPARENT, BBEP_BLACK);
+    fclose(f);
+    if (rc != BBEP_SUCCESS) {
+        ESP_LOGW(TAG, "Failed to draw %s (%d)", path, rc);
+    }
+}
+#endif // CONFIG_DISPLAY_SITE_BACKGROUND
+
 extern "C" void display_site_data(void)
 {
     ESP_LOGI(TAG, "Drawing site data");
@@ -113,21 +380,37 @@ extern "C" void display_site_data(void)
     epd_power_control(true);
     vTaskDelay(pdMS_TO_TICKS(50));  // Allow display to wake up
 
-    // Clear screen to white
-    epd->fillScreen(BBEP_WHITE);
-    epd->setTextColor(BBEP_BLACK, BBEP_WHITE);
-
-    // Draw all sections
-    draw_heading_section();
-    draw_graph_section(0, 0);  // Graphs fill the screen below header
+#ifdef CONFIG_DISPLAY_FRAME_CACHE
+    int64_t start_us = esp_timer_get_time();
+    uint32_t key = frame_key();
+    frame_cache_entry_t* entry = frame_cache_entry();
+    if (frame_cache_load(entry, key)) {
+        ESP_LOGD(TAG, "Cached screen decoded in %d us", (int)(esp_timer_get_time() - start_us));
+    } else
+#endif
+    {
+        // Clear screen to white, leaving the previous frame in PLANE_1
+        epd->fillScreen(BBEP_WHITE, PLANE_0);
+#ifdef CONFIG_DISPLAY_SITE_BACKGROUND
+        draw_site_background();
+#endif
+        epd->setTextColor(BBEP_BLACK, BBEP_WHITE);
+
+        // Draw all sections
+        draw_heading_section();
+        draw_graph_section(0, 0);  // Graphs fill the screen below header
+#ifdef CONFIG_DISPLAY_FRAME_CACHE
+        ESP_LOGD(TAG, "Screen drawn in %d us", (int)(esp_timer_get_time() - start_us));
+        frame_cache_store(entry, key);
+#endif
+    }
 
     // Write buffer to display and refresh
     ESP_LOGD(TAG, "Updating display...");
-    epd->writePlane();
-    epd->refresh(REFRESH_FULL, true);   // Always use full refresh
+    update_display();
 
-    ESP_LOGD(TAG, "Display updated! Data time: %d ms, Op time: %d ms",
-             epd->dataTime(), epd->opTime());
+    ESP_LOGD(TAG, "Display updated! Data time: %d ms, Op time: %d ms, Cmd time: %d us",
+             epd->dataTime(), epd->opTime(), epd->cmdTime());
 
     // Put display to sleep
     epd->sleep(DEEP_SLEEP);
@@ -146,7 +429,7 @@ extern "C" void display_no_data(void)
     epd_power_control(true);
     vTaskDelay(pdMS_TO_TICKS(50));  // Allow display to wake up
 
-    epd->fillScreen(BBEP_WHITE);
+    epd->fillScreen(BBEP_WHITE, PLANE_0);
     epd->setTextColor(BBEP_BLACK, BBEP_WHITE);
 
     draw_heading_section();
@@ -160,8 +443,7 @@ extern "C" void display_no_data(void)
     epd->drawString(msg1, msg1_x, 120);
     epd->drawString(msg2, msg2_x, 150);
 
-    epd->writePlane();
-    epd->refresh(REFRESH_FULL, true);
+    update_display();
 
     epd->sleep(DEEP_SLEEP);
     epd_power_control(false);
@@ -179,7 +461,7 @@ extern "C" void display_wifi_error(void)
     epd_power_control(true);
     vTaskDelay(pdMS_TO_TICKS(50));  // Allow display to wake up
 
-    epd->fillScreen(BBEP_WHITE);
+    epd->fillScreen(BBEP_WHITE, PLANE_0);
     epd->setTextColor(BBEP_BLACK, BBEP_WHITE);
 
     draw_heading_section();
@@ -198,8 +480,7 @@ extern "C" void display_wifi_error(void)
     epd->setFont(FONT_12x16);
     epd->drawString(CONFIG_WIFI_SSID, ssid_x, 160);
 
-    epd->writePlane();
-    epd->refresh(REFRESH_FULL, true);
+    update_display();
 
     epd->sleep(DEEP_SLEEP);
     epd_power_control(false);
@@ -254,58 +535,32 @@ static void draw_heading_section(void)
 
 static void draw_graph_section(int x, int y)
 {
-    // Allocate on heap to avoid stack overflow
-    float* temperature_readings = (float*)malloc(MAX_READINGS * sizeof(float));
-    float* water_temp_readings = (float*)malloc(MAX_READINGS * sizeof(float));
-    float* pressure_readings = (float*)malloc(MAX_READINGS * sizeof(float));
-    float* hourly_temp = (float*)malloc(MAX_HOURLY_READINGS * sizeof(float));
-    float* hourly_water = (float*)malloc(MAX_HOURLY_READINGS * sizeof(float));
-    float* hourly_pressure = (float*)malloc(MAX_HOURLY_READINGS * sizeof(float));
-
-    if (!temperature_readings || !water_temp_readings || !pressure_readings ||
-        !hourly_temp || !hourly_water || !hourly_pressure) {
-        ESP_LOGE(TAG, "Failed to allocate memory for graph data");
-        // Free any allocated memory
-        free(temperature_readings);
-        free(water_temp_readings);
-        free(pressure_readings);
-        free(hourly_temp);
-        free(hourly_water);
-        free(hourly_pressure);
+    // Graphs read the oldest-first columns of the current site directly
+    const site_readings_t* readings = g_site_readings;
+    if (readings == NULL) {
+        ESP_LOGW(TAG, "No readings to graph");
         return;
     }
 
-    // Prepare 5-minute data arrays (reverse order - oldest first)
-    for (int r = 0; r < g_num_readings; r++) {
-        int idx = g_num_readings - 1 - r;
-        temperature_readings[r] = g_site_readings[idx].temperature;
-        water_temp_readings[r] = g_site_readings[idx].water_temp;
-        pressure_readings[r] = g_site_readings[idx].pressure;
-    }
-
-    // Allocate arrays for data availability flags
+    // Allocate on heap to avoid stack overflow
+    float* hourly_temp = (float*)malloc(MAX_HOURLY_READINGS * sizeof(float));
     bool* has_temp_data = (bool*)malloc(MAX_HOURLY_READINGS * sizeof(bool));
 
-    if (!has_temp_data) {
-        ESP_LOGE(TAG, "Failed to allocate memory for data flags");
-        free(has_temp_data);
-        free(temperature_readings);
-        free(water_temp_readings);
-        free(pressure_readings);
+    if (!hourly_temp || !has_temp_data) {
+        ESP_LOGE(TAG, "Failed to allocate memory for graph data");
         free(hourly_temp);
-        free(hourly_water);
-        free(hourly_pressure);
+        free(has_temp_data);
         return;
     }
 
     // Aggregate only air temperature to full 24 hours with missing data marked
-    aggregate_to_24_hours(temperature_readings, g_num_readings, hourly_temp, has_temp_data);
+    aggregate_to_24_hours(readings->temperature, readings->count, hourly_temp, has_temp_data);
 
     int available_hours = 0;
     for (int i = 0; i < MAX_HOURLY_READINGS; i++) {
         if (has_temp_data[i]) available_hours++;
     }
-    ESP_LOGD(TAG, "Aggregated %d readings into %d hours (out of 24)", g_num_readings, available_hours);
+    ESP_LOGD(TAG, "Aggregated %d readings into %d hours (out of 24)", readings->count, available_hours);
 
     // Full screen layout - 3 graphs stacked vertically
     int start_y = 32;  // Just below header (FONT_16x16=16px + margins + double line at 28px)
@@ -320,12 +575,12 @@ static void draw_graph_section(int x, int y)
 
     // Water Temperature Graph (line graph) - 5-minute readings, y-axis starts at 0
     display_draw_graph(5, start_y + graph_h + graph_spacing, graph_w, graph_h, 0, 10,
-                       "Water Temp", water_temp_readings, g_num_readings,
+                       "Water Temp", readings->water_temp, readings->count,
                        true, false, NULL);
 
     // Pressure Graph (line graph) - 5-minute readings, y-axis starts at 0
     display_draw_graph(5, start_y + 2 * (graph_h + graph_spacing), graph_w, graph_h, 0, 2,
-                       "Pressure", pressure_readings, g_num_readings,
+                       "Pressure", readings->pressure, readings->count,
                        true, false, NULL);
 
     // Draw vertical dashed lines for hourly markers across all three graphs
@@ -366,18 +621,13 @@ static void draw_graph_section(int x, int y)
     draw_common_x_axis(5, start_y + 3 * graph_h + 2 * graph_spacing, graph_w);
 
     // Free allocated memory
-    free(temperature_readings);
-    free(water_temp_readings);
-    free(pressure_readings);
     free(hourly_temp);
-    free(hourly_water);
-    free(hourly_pressure);
     free(has_temp_data);
 }
 
 extern "C" void display_draw_graph(int x_pos, int y_pos, int gwidth, int gheight,
                                    float y_min, float y_max, const char* title,
-                                   float* data, int readings,
+                                   const float* data, int readings,
                                    bool auto_scale, bool bar_chart, bool* has_data)
 {
     const int margin_left = 4;   // Small left margin
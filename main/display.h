@@ -7,6 +7,7 @@
 #define DISPLAY_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
  * @brief Initialize the display subsystem
@@ -33,6 +34,16 @@ void display_wifi_error(void);
  */
 void display_power_off(void);
 
+#ifdef DISPLAY_HOST
+/**
+ * @brief Get the frame drawn on the virtual panel (host builds only)
+ * @param width Set to the frame width in pixels
+ * @param height Set to the frame height in pixels
+ * @return 1-bpp rows, MSB first, 1 = white; NULL before display_init()
+ */
+const uint8_t* display_get_frame(int* width, int* height);
+#endif
+
 /**
  * @brief Draw a graph on the display
  * @param x_pos X position
@@ -50,7 +61,7 @@ void display_power_off(void);
  */
 void display_draw_graph(int x_pos, int y_pos, int width, int height,
                         float y_min, float y_max, const char* title,
-                        float* data, int readings,
+                        const float* data, int readings,
                         bool auto_scale, bool bar_chart, bool* has_data);
 
 #endif // DISPLAY_H
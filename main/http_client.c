@@ -9,6 +9,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_http_client.h"
 #include "esp_crt_bundle.h"
 
@@ -17,12 +18,47 @@
 
 static const char* TAG = "http_client";
 
-#define MAX_HTTP_OUTPUT_BUFFER 49152  // 48KB for 288 readings
-
-// Response buffer
-static char* s_response_buffer = NULL;
+// Response is parsed as it arrives, so no body buffer is needed
+static site_parser_t s_parser;
 static int s_response_len = 0;
 
+#if CONFIG_SITE_BINARY_FORMAT
+// Binary responses are small, they are collected and decoded at the end
+static uint8_t s_bin_buffer[SITE_BIN_MAX_SIZE];
+static int s_bin_len = 0;
+static bool s_is_binary = false;
+static bool s_bin_overflow = false;     // Body didn't fit, the fetch fails
+#endif
+
+// Persistent client kept open between http_client_begin/end_session()
+static esp_http_client_handle_t s_session_client = NULL;
+
+static void handle_body(const char* data, int len)
+{
+#if CONFIG_SITE_BINARY_FORMAT
+    // The server may not support format=bin, so sniff the first byte
+    if (s_response_len == 0 && len > 0) {
+        s_is_binary = (data[0] == SITE_BIN_MAGIC[0]);
+    }
+
+    if (s_is_binary) {
+        // Once a chunk is lost, later ones must not be spliced on behind it
+        if (s_bin_overflow) {
+            return;
+        }
+        if (s_bin_len + len <= (int)sizeof(s_bin_buffer)) {
+            memcpy(s_bin_buffer + s_bin_len, data, len);
+            s_bin_len += len;
+        } else {
+            ESP_LOGW(TAG, "Binary response buffer overflow");
+            s_bin_overflow = true;
+        }
+        return;
+    }
+#endif
+    site_parser_feed(&s_parser, data, len);
+}
+
 static esp_err_t http_event_handler(esp_http_client_event_t* evt)
 {
     switch (evt->event_id) {
@@ -45,16 +81,11 @@ static esp_err_t http_event_handler(esp_http_client_event_t* evt)
 
         case HTTP_EVENT_ON_DATA:
             ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-            if (s_response_buffer != NULL) {
-                // Check buffer overflow
-                if (s_response_len + evt->data_len < MAX_HTTP_OUTPUT_BUFFER) {
-                    memcpy(s_response_buffer + s_response_len, evt->data, evt->data_len);
-                    s_response_len += evt->data_len;
-                    s_response_buffer[s_response_len] = '\0';
-                } else {
-                    ESP_LOGW(TAG, "Response buffer overflow");
-                }
+            // Only feed successful responses, error bodies are not site data
+            if (esp_http_client_get_status_code(evt->client) == 200) {
+                handle_body((const char*)evt->data, evt->data_len);
             }
+            s_response_len += evt->data_len;
             break;
 
         case HTTP_EVENT_ON_FINISH:
@@ -72,42 +103,101 @@ static esp_err_t http_event_handler(esp_http_client_event_t* evt)
     return ESP_OK;
 }
 
-bool fetch_site_data(const char* site_name, int count, bool print)
+static esp_http_client_handle_t create_client(const char* url)
 {
-    bool success = false;
+    esp_http_client_config_t config = {
+        .url = url,
+        .event_handler = http_event_handler,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .timeout_ms = 10000,
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        // Resume TLS with a session ticket if the server drops the socket
+        .save_client_session = true,
+#endif
+    };
+
+    return esp_http_client_init(&config);
+}
+
+static void build_url(char* url, size_t url_len, const char* site_name, int count,
+                      int32_t since)
+{
+    int len = snprintf(url, url_len, "https://%s%s?site_name=%s&count=%d",
+                       CONFIG_SITE_API_SERVER, CONFIG_SITE_API_PATH, site_name, count);
+
+    if (since > 0 && len > 0 && (size_t)len < url_len) {
+        len += snprintf(url + len, url_len - len, "&since=%" PRId32, since);
+    }
+#if CONFIG_SITE_BINARY_FORMAT
+    if (len > 0 && (size_t)len < url_len) {
+        snprintf(url + len, url_len - len, "&format=bin");
+    }
+#endif
+}
 
-    // Allocate response buffer
-    s_response_buffer = malloc(MAX_HTTP_OUTPUT_BUFFER);
-    if (s_response_buffer == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate response buffer");
-        return false;
+esp_err_t http_client_begin_session(void)
+{
+    if (s_session_client != NULL) {
+        return ESP_OK;
+    }
+
+    // URL is replaced per request, the host stays the same
+    char url[256];
+    build_url(url, sizeof(url), "", 0, 0);
+
+    s_session_client = create_client(url);
+    if (s_session_client == NULL) {
+        ESP_LOGE(TAG, "Failed to initialize HTTP session");
+        return ESP_FAIL;
     }
+
+    ESP_LOGD(TAG, "HTTP session opened");
+    return ESP_OK;
+}
+
+void http_client_end_session(void)
+{
+    if (s_session_client != NULL) {
+        esp_http_client_cleanup(s_session_client);
+        s_session_client = NULL;
+        ESP_LOGD(TAG, "HTTP session closed");
+    }
+}
+
+bool fetch_site_data(const char* site_name, int count, int32_t since,
+                     site_readings_t* readings, bool print)
+{
+    bool success = false;
+
+    site_parser_init(&s_parser, readings);
     s_response_len = 0;
-    memset(s_response_buffer, 0, MAX_HTTP_OUTPUT_BUFFER);
+#if CONFIG_SITE_BINARY_FORMAT
+    s_bin_len = 0;
+    s_is_binary = false;
+    s_bin_overflow = false;
+#endif
 
     // Build URL
     char url[256];
-    snprintf(url, sizeof(url), "https://%s%s?site_name=%s&count=%d",
-             CONFIG_SITE_API_SERVER, CONFIG_SITE_API_PATH, site_name, count);
+    build_url(url, sizeof(url), site_name, count, since);
 
     ESP_LOGI(TAG, "Fetching: %s", url);
 
-    esp_http_client_config_t config = {
-        .url = url,
-        .event_handler = http_event_handler,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .timeout_ms = 10000,
-    };
-
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        ESP_LOGE(TAG, "Failed to initialize HTTP client");
-        free(s_response_buffer);
-        s_response_buffer = NULL;
-        return false;
+    // Reuse the open session if there is one, else use a one-shot client
+    esp_http_client_handle_t client = s_session_client;
+    if (client != NULL) {
+        esp_http_client_set_url(client, url);
+    } else {
+        client = create_client(url);
+        if (client == NULL) {
+            ESP_LOGE(TAG, "Failed to initialize HTTP client");
+            return false;
+        }
     }
 
+    int64_t start_time = esp_timer_get_time();
     esp_err_t err = esp_http_client_perform(client);
+    ESP_LOGD(TAG, "Request took %" PRId64 " ms", (esp_timer_get_time() - start_time) / 1000);
 
     if (err == ESP_OK) {
         int status_code = esp_http_client_get_status_code(client);
@@ -117,16 +207,24 @@ bool fetch_site_data(const char* site_name, int count, bool print)
                  status_code, content_length);
 
         if (status_code == 200 && s_response_len > 0) {
-            if (print) {
-                ESP_LOGD(TAG, "Response: %s", s_response_buffer);
+#if CONFIG_SITE_BINARY_FORMAT
+            if (s_is_binary) {
+                if (s_bin_overflow) {
+                    ESP_LOGE(TAG, "Binary response larger than %u bytes",
+                             (unsigned)sizeof(s_bin_buffer));
+                } else {
+                    success = parse_site_data_binary(s_bin_buffer, s_bin_len, readings, print);
+                }
+            } else
+#endif
+            {
+                // Body was already parsed chunk by chunk in the event handler
+                success = site_parser_finish(&s_parser, print);
             }
-
-            // Parse JSON response
-            success = parse_site_data(s_response_buffer, print);
             if (success) {
                 ESP_LOGD(TAG, "Data parsed successfully");
             } else {
-                ESP_LOGE(TAG, "Failed to parse JSON response");
+                ESP_LOGE(TAG, "Failed to parse response");
             }
         } else {
             ESP_LOGE(TAG, "HTTP error: status=%d, len=%d", status_code, s_response_len);
@@ -135,9 +233,12 @@ bool fetch_site_data(const char* site_name, int count, bool print)
         ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(err));
     }
 
-    esp_http_client_cleanup(client);
-    free(s_response_buffer);
-    s_response_buffer = NULL;
+    if (client != s_session_client) {
+        esp_http_client_cleanup(client);
+    } else if (err != ESP_OK || !success) {
+        // Drop a possibly half-read connection, the next perform reconnects
+        esp_http_client_close(client);
+    }
 
     return success;
 }
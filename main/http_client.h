@@ -7,15 +7,36 @@
 #define HTTP_CLIENT_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "esp_err.h"
+#include "site_data.h"
 
 /**
  * @brief Fetch site data from API
  * @param site_name Site name to query
  * @param count Number of historical readings to fetch
+ * @param since Only fetch readings newer than this Unix time (0 = all)
+ * @param readings Destination the response readings are parsed into
  * @param print If true, print response info
  * @return true on success, false on failure
  */
-bool fetch_site_data(const char* site_name, int count, bool print);
+bool fetch_site_data(const char* site_name, int count, int32_t since,
+                     site_readings_t* readings, bool print);
+
+/**
+ * @brief Open a persistent connection for a batch of fetches
+ *
+ * Until http_client_end_session() is called, fetch_site_data() reuses one
+ * keep-alive connection and only changes the URL per request. If the server
+ * closes the socket, the reconnect resumes TLS with a session ticket.
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t http_client_begin_session(void);
+
+/**
+ * @brief Close the persistent connection opened by http_client_begin_session()
+ */
+void http_client_end_session(void);
 
 #endif // HTTP_CLIENT_H
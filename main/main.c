@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <inttypes.h>
+#include <time.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -22,6 +23,8 @@
 #include "http_client.h"
 #include "site_data.h"
 #include "nvs_storage.h"
+#include "site_store.h"
+#include "sleep_manager.h"
 #include "display.h"
 #include "lang.h"
 
@@ -34,20 +37,26 @@ static const char* TAG = "main";
 char g_time_str[16] = {0};
 char g_date_str[32] = {0};
 
+// Shortest deep sleep, so a refresh that ran late does not wake straight away
+#define SLEEP_MIN_SEC 10
+
 // Button event queue
 static QueueHandle_t s_button_queue = NULL;
 
 // Per-site data cache (on-demand allocation to save memory)
 typedef struct {
     bool has_data;
-    site_reading_t* readings;  // Allocated on-demand
-    int num_readings;
+    site_readings_t* readings;  // Allocated on-demand, owned by the cache
+    bool store_checked;         // Flash copy already looked for
     char time_str[16];
     char date_str[32];
 } site_cache_t;
 
 static site_cache_t* s_site_cache = NULL;
 
+// Spare buffer a fetch parses into, swapped with the cache slot on success
+static site_readings_t* s_fetch_buffer = NULL;
+
 typedef enum {
     BTN_EVENT_NONE = 0,
     BTN_EVENT_UP,
@@ -64,10 +73,19 @@ static bool update_local_time(void);
 static void fetch_and_display(void);
 static void gpio_isr_handler(void* arg);
 static void button_task(void* arg);
+static bool fetch_site_readings(int site_index, bool print);
+static void load_stored_site(int site_index);
 static void load_cached_site_data(int site_index);
 static void save_current_site_data(int site_index);
 static void display_current_site(void);
 static void first_boot_fetch_all_sites(void);
+static void fetch_all_and_display(void);
+static void change_site(int step);
+#if CONFIG_SLEEP_REFRESH_ENABLE
+static bool handle_deep_sleep_wake(void);
+static void scheduled_refresh(void);
+static void enter_deep_sleep(void);
+#endif
 
 void app_main(void)
 {
@@ -81,6 +99,9 @@ void app_main(void)
     // Initialize NVS
     ESP_ERROR_CHECK(nvs_storage_init());
 
+    // Mount flash-backed site cache (runs without it if mounting fails)
+    site_store_init();
+
     // Allocate cache for all sites
     s_site_cache = (site_cache_t*)calloc(g_num_sites, sizeof(site_cache_t));
     if (s_site_cache == NULL) {
@@ -98,6 +119,17 @@ void app_main(void)
         g_current_site_index = 0;
     }
 
+#if CONFIG_SLEEP_REFRESH_ENABLE
+    // The site on screen before deep sleep takes precedence over NVS
+    if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_UNDEFINED && sleep_state_valid()) {
+        if (g_sleep_state.site_index >= 0 && g_sleep_state.site_index < g_num_sites) {
+            g_current_site_index = g_sleep_state.site_index;
+        }
+    } else {
+        sleep_state_reset();
+    }
+#endif
+
     // Set current site name
     g_site_name = g_site_list[g_current_site_index];
     ESP_LOGI(TAG, "Site: %s (index %d)", g_site_name, g_current_site_index);
@@ -105,12 +137,21 @@ void app_main(void)
     // Initialize display
     display_init();
 
+#if CONFIG_SLEEP_REFRESH_ENABLE
+    // Timer and button wakes are served here and go straight back to sleep
+    if (handle_deep_sleep_wake()) {
+        enter_deep_sleep();
+    }
+#endif
+
     // Setup GPIO for buttons
     setup_gpio();
 
-    // Initialize current site - no cached data initially
-    g_data_loaded = false;
-    g_num_readings = 0;
+    // Paint the last known screen from flash before bringing up the radio
+    load_cached_site_data(g_current_site_index);
+    if (g_data_loaded) {
+        display_current_site();
+    }
 
     // Connect to WiFi
     esp_err_t wifi_ret = wifi_connect();
@@ -121,7 +162,7 @@ void app_main(void)
         // If no sites have cached data, treat as first boot
         bool has_any_cache = false;
         for (int i = 0; i < g_num_sites && s_site_cache != NULL; i++) {
-            if (s_site_cache[i].has_data) {
+            if (s_site_cache[i].has_data || site_store_exists(i)) {
                 has_any_cache = true;
                 break;
             }
@@ -139,13 +180,16 @@ void app_main(void)
             // Load cached data for current site
             load_cached_site_data(g_current_site_index);
             display_current_site();
-        } else {
+        } else if (!g_data_loaded) {
             ESP_LOGI(TAG, "Not first boot - showing no data screen");
             display_no_data();
         }
     } else {
         ESP_LOGE(TAG, "WiFi connection failed");
-        display_wifi_error();
+        // Keep showing the cached screen if there is one
+        if (!g_data_loaded) {
+            display_wifi_error();
+        }
     }
 
     // Create button task (increased stack for 288 readings)
@@ -200,8 +244,15 @@ static void button_task(void* arg)
     TickType_t last_event_time[5] = {0};  // Track debounce per button type (5 buttons now)
     const TickType_t debounce_ticks = pdMS_TO_TICKS(500);  // Increased debounce time
 
+#if CONFIG_SLEEP_REFRESH_ENABLE
+    // Deep sleep once the buttons have been left alone for a while
+    const TickType_t idle_ticks = pdMS_TO_TICKS(CONFIG_SLEEP_IDLE_TIMEOUT_SEC * 1000);
+#else
+    const TickType_t idle_ticks = portMAX_DELAY;
+#endif
+
     while (1) {
-        if (xQueueReceive(s_button_queue, &event, portMAX_DELAY)) {
+        if (xQueueReceive(s_button_queue, &event, idle_ticks)) {
             // Debounce per button type
             TickType_t now = xTaskGetTickCount();
             int button_idx = (int)event - 1;  // Convert event to index (0-4)
@@ -216,32 +267,18 @@ static void button_task(void* arg)
             switch (event) {
                 case BTN_EVENT_UP:
                     ESP_LOGI(TAG, "Rotary: UP");
-                    g_current_site_index = (g_current_site_index + 1) % g_num_sites;
-                    g_site_name = g_site_list[g_current_site_index];
-                    nvs_save_site_index(g_current_site_index);
-                    ESP_LOGI(TAG, "Site changed to: %s", g_site_name);
 
                     // Clear any pending button events while display is updating
                     xQueueReset(s_button_queue);
-
-                    // Load cached data for this site and display
-                    load_cached_site_data(g_current_site_index);
-                    display_current_site();
+                    change_site(1);
                     break;
 
                 case BTN_EVENT_DOWN:
                     ESP_LOGI(TAG, "Rotary: DOWN");
-                    g_current_site_index = (g_current_site_index - 1 + g_num_sites) % g_num_sites;
-                    g_site_name = g_site_list[g_current_site_index];
-                    nvs_save_site_index(g_current_site_index);
-                    ESP_LOGI(TAG, "Site changed to: %s", g_site_name);
 
                     // Clear any pending button events while display is updating
                     xQueueReset(s_button_queue);
-
-                    // Load cached data for this site and display
-                    load_cached_site_data(g_current_site_index);
-                    display_current_site();
+                    change_site(-1);
                     break;
 
                 case BTN_EVENT_MID:
@@ -257,31 +294,14 @@ static void button_task(void* arg)
 
                     // Clear any pending button events while fetching all sites
                     xQueueReset(s_button_queue);
-
-                    // Check WiFi connection
-                    if (!wifi_is_connected()) {
-                        ESP_LOGI(TAG, "WiFi not connected, reconnecting...");
-                        if (wifi_connect() != ESP_OK) {
-                            ESP_LOGE(TAG, "WiFi reconnect failed - cannot fetch all sites");
-                            display_wifi_error();
-                            break;
-                        }
-                        ESP_LOGI(TAG, "WiFi reconnected");
-                    }
-
-                    // Setup time and fetch all sites
-                    setup_time();
-                    if (update_local_time()) {
-                        first_boot_fetch_all_sites();
-                        // Load cached data for current site and display
-                        load_cached_site_data(g_current_site_index);
-                        display_current_site();
-                    } else {
-                        ESP_LOGE(TAG, "NTP time sync failed - cannot fetch all sites");
-                    }
+                    fetch_all_and_display();
                     break;
 
                 case BTN_EVENT_EXIT:
+#if CONFIG_SLEEP_REFRESH_ENABLE
+                    ESP_LOGI(TAG, "Exit: PRESS (entering deep sleep)");
+                    enter_deep_sleep();
+#else
                     ESP_LOGI(TAG, "Exit: PRESS (entering light sleep)");
 
                     // Power off display
@@ -303,12 +323,56 @@ static void button_task(void* arg)
 
                     // Small delay for button release
                     vTaskDelay(pdMS_TO_TICKS(500));
+#endif
                     break;
 
                 default:
                     break;
             }
         }
+#if CONFIG_SLEEP_REFRESH_ENABLE
+        else {
+            ESP_LOGI(TAG, "No input for %d s", CONFIG_SLEEP_IDLE_TIMEOUT_SEC);
+            enter_deep_sleep();
+        }
+#endif
+    }
+}
+
+static void change_site(int step)
+{
+    g_current_site_index = (g_current_site_index + step + g_num_sites) % g_num_sites;
+    g_site_name = g_site_list[g_current_site_index];
+    nvs_save_site_index(g_current_site_index);
+    ESP_LOGI(TAG, "Site changed to: %s", g_site_name);
+
+    // Load cached data for this site and display
+    load_cached_site_data(g_current_site_index);
+    display_current_site();
+}
+
+static void fetch_all_and_display(void)
+{
+    // Check WiFi connection
+    if (!wifi_is_connected()) {
+        ESP_LOGI(TAG, "WiFi not connected, reconnecting...");
+        if (wifi_connect() != ESP_OK) {
+            ESP_LOGE(TAG, "WiFi reconnect failed - cannot fetch all sites");
+            display_wifi_error();
+            return;
+        }
+        ESP_LOGI(TAG, "WiFi reconnected");
+    }
+
+    // Setup time and fetch all sites
+    setup_time();
+    if (update_local_time()) {
+        first_boot_fetch_all_sites();
+        // Load cached data for current site and display
+        load_cached_site_data(g_current_site_index);
+        display_current_site();
+    } else {
+        ESP_LOGE(TAG, "NTP time sync failed - cannot fetch all sites");
     }
 }
 
@@ -331,7 +395,7 @@ static void fetch_and_display(void)
 
         bool rx_data = false;
         for (int i = 0; i < 2 && !rx_data; i++) {
-            rx_data = fetch_site_data(g_site_name, CONFIG_SITE_READING_COUNT, true);
+            rx_data = fetch_site_readings(g_current_site_index, true);
             if (!rx_data) {
                 ESP_LOGW(TAG, "Fetch attempt %d failed, retrying...", i + 1);
                 vTaskDelay(pdMS_TO_TICKS(1000));
@@ -353,11 +417,103 @@ static void fetch_and_display(void)
     }
 }
 
+static bool fetch_site_readings(int site_index, bool print)
+{
+    if (s_site_cache == NULL) {
+        return false;
+    }
+
+    site_cache_t* cache = &s_site_cache[site_index];
+
+    // Stored readings let the fetch be a delta even right after boot
+    if (!cache->has_data && !cache->store_checked) {
+        load_stored_site(site_index);
+    }
+
+    // Parse into the spare buffer so a failed fetch leaves the cache intact
+    if (s_fetch_buffer == NULL) {
+        s_fetch_buffer = (site_readings_t*)malloc(sizeof(site_readings_t));
+        if (s_fetch_buffer == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate fetch buffer");
+            return false;
+        }
+    }
+    // A response without a readings array must not leave stale data
+    s_fetch_buffer->count = 0;
+
+    int32_t since = 0;
+
+#if CONFIG_SITE_DELTA_FETCH
+    // Ask only for readings newer than the cache, unless the gap is a full window
+    if (cache->has_data && cache->readings != NULL && cache->readings->count > 0) {
+        int32_t newest = cache->readings->dt[cache->readings->count - 1];
+        int64_t gap = (int64_t)time(NULL) - newest;
+        if (gap < (int64_t)CONFIG_SITE_READING_COUNT * READING_INTERVAL_SEC) {
+            since = newest;
+        }
+    }
+#endif
+
+    if (!fetch_site_data(g_site_list[site_index], CONFIG_SITE_READING_COUNT, since,
+                         s_fetch_buffer, print)) {
+        return false;
+    }
+
+    if (since != 0) {
+        int added = merge_site_readings(cache->readings, s_fetch_buffer, since,
+                                        CONFIG_SITE_READING_COUNT);
+        ESP_LOGI(TAG, "Delta fetch for %s: %d new readings", g_site_list[site_index], added);
+    } else if (s_fetch_buffer->count == 0) {
+        // A valid but empty response leaves the cached readings in place
+        ESP_LOGW(TAG, "No readings for %s", g_site_list[site_index]);
+        return false;
+    } else {
+        // Swap the parsed buffer into the slot, the old one becomes the spare
+        site_readings_t* old = cache->readings;
+        cache->readings = s_fetch_buffer;
+        s_fetch_buffer = old;
+        if (old != NULL && g_site_readings == old) {
+            g_site_readings = cache->readings;
+        }
+    }
+
+    return true;
+}
+
+static void load_stored_site(int site_index)
+{
+    site_cache_t* cache = &s_site_cache[site_index];
+
+    cache->store_checked = true;
+    if (!site_store_exists(site_index)) {
+        return;
+    }
+
+    if (cache->readings == NULL) {
+        cache->readings = (site_readings_t*)malloc(sizeof(site_readings_t));
+        if (cache->readings == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate cache for %s", g_site_list[site_index]);
+            return;
+        }
+    }
+
+    int64_t start_time = esp_timer_get_time();
+    esp_err_t ret = site_store_load(site_index, cache->readings,
+                                    cache->time_str, sizeof(cache->time_str),
+                                    cache->date_str, sizeof(cache->date_str));
+    if (ret == ESP_OK && cache->readings->count > 0) {
+        cache->has_data = true;
+        ESP_LOGI(TAG, "Loaded %s from flash (%d readings) in %" PRId64 " ms",
+                 g_site_list[site_index], cache->readings->count,
+                 (esp_timer_get_time() - start_time) / 1000);
+    }
+}
+
 static void load_cached_site_data(int site_index)
 {
     if (s_site_cache == NULL || site_index < 0 || site_index >= g_num_sites) {
         g_data_loaded = false;
-        g_num_readings = 0;
+        g_site_readings = NULL;
         memset(g_time_str, 0, sizeof(g_time_str));
         memset(g_date_str, 0, sizeof(g_date_str));
         return;
@@ -365,18 +521,22 @@ static void load_cached_site_data(int site_index)
 
     site_cache_t* cache = &s_site_cache[site_index];
 
-    if (cache->has_data && cache->readings != NULL && cache->num_readings > 0) {
-        // Restore cached data to global variables
-        memcpy(g_site_readings, cache->readings, sizeof(site_reading_t) * cache->num_readings);
-        g_num_readings = cache->num_readings;
+    // Sites are read from flash the first time they are shown
+    if (!cache->has_data && !cache->store_checked) {
+        load_stored_site(site_index);
+    }
+
+    if (cache->has_data && cache->readings != NULL && cache->readings->count > 0) {
+        // Point at the cached buffer, switching sites copies no readings
+        g_site_readings = cache->readings;
         strncpy(g_time_str, cache->time_str, sizeof(g_time_str));
         strncpy(g_date_str, cache->date_str, sizeof(g_date_str));
         g_data_loaded = true;
-        ESP_LOGI(TAG, "Loaded cached data for %s (%d readings)", g_site_name, g_num_readings);
+        ESP_LOGI(TAG, "Loaded cached data for %s (%d readings)", g_site_name, g_site_readings->count);
     } else {
         // No cached data - clear everything
         g_data_loaded = false;
-        g_num_readings = 0;
+        g_site_readings = NULL;
         memset(g_time_str, 0, sizeof(g_time_str));
         memset(g_date_str, 0, sizeof(g_date_str));
         ESP_LOGD(TAG, "No cached data for %s", g_site_name);
@@ -385,34 +545,31 @@ static void load_cached_site_data(int site_index)
 
 static void save_current_site_data(int site_index)
 {
-    if (s_site_cache == NULL || site_index < 0 || site_index >= g_num_sites || g_num_readings == 0) {
+    if (s_site_cache == NULL || site_index < 0 || site_index >= g_num_sites) {
         return;
     }
 
     site_cache_t* cache = &s_site_cache[site_index];
 
-    // Free old cache if it exists
-    if (cache->readings != NULL) {
-        free(cache->readings);
-        cache->readings = NULL;
-    }
-
-    // Allocate memory for readings
-    cache->readings = (site_reading_t*)malloc(sizeof(site_reading_t) * g_num_readings);
-    if (cache->readings == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate cache for %s", g_site_name);
-        cache->has_data = false;
+    // The fetch already parsed into the cache slot, just make it current
+    g_site_readings = cache->readings;
+    if (cache->readings == NULL || cache->readings->count == 0) {
         return;
     }
 
-    // Save current data to cache
-    memcpy(cache->readings, g_site_readings, sizeof(site_reading_t) * g_num_readings);
-    cache->num_readings = g_num_readings;
     strncpy(cache->time_str, g_time_str, sizeof(cache->time_str));
     strncpy(cache->date_str, g_date_str, sizeof(cache->date_str));
     cache->has_data = true;
 
-    ESP_LOGI(TAG, "Cached data for %s (%d readings)", g_site_name, g_num_readings);
+    // Remember what was fetched so a timer wake can tell if anything changed
+    if (site_index < SLEEP_MAX_SITES) {
+        g_sleep_state.last_fetch_dt[site_index] = cache->readings->dt[cache->readings->count - 1];
+    }
+
+    // Persist so the next boot can show it without a fetch
+    site_store_save(site_index, cache->readings, cache->time_str, cache->date_str);
+
+    ESP_LOGI(TAG, "Cached data for %s (%d readings)", g_site_name, cache->readings->count);
 }
 
 static void display_current_site(void)
@@ -439,6 +596,10 @@ static void first_boot_fetch_all_sites(void)
     // Save original site index
     int original_site = g_current_site_index;
 
+    // Keep one connection open for all sites to skip repeated TLS handshakes
+    int64_t start_time = esp_timer_get_time();
+    http_client_begin_session();
+
     // Fetch data for each site
     for (int i = 0; i < g_num_sites; i++) {
         g_current_site_index = i;
@@ -448,7 +609,7 @@ static void first_boot_fetch_all_sites(void)
 
         bool success = false;
         for (int retry = 0; retry < 2 && !success; retry++) {
-            success = fetch_site_data(g_site_name, CONFIG_SITE_READING_COUNT, false);
+            success = fetch_site_readings(i, false);
             if (!success && retry < 1) {
                 ESP_LOGW(TAG, "Retry fetching %s...", g_site_name);
                 vTaskDelay(pdMS_TO_TICKS(1000));
@@ -475,6 +636,10 @@ static void first_boot_fetch_all_sites(void)
         vTaskDelay(pdMS_TO_TICKS(500));
     }
 
+    http_client_end_session();
+    ESP_LOGI(TAG, "Fetched all sites in %" PRId64 " ms",
+             (esp_timer_get_time() - start_time) / 1000);
+
     // Restore original site
     g_current_site_index = original_site;
     g_site_name = g_site_list[original_site];
@@ -482,6 +647,118 @@ static void first_boot_fetch_all_sites(void)
     ESP_LOGI(TAG, "First boot fetch completed");
 }
 
+#if CONFIG_SLEEP_REFRESH_ENABLE
+static bool handle_deep_sleep_wake(void)
+{
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+    if (cause != ESP_SLEEP_WAKEUP_TIMER && cause != ESP_SLEEP_WAKEUP_EXT1) {
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Wake #%" PRIu32 " (%s), %s last showed %.1f C",
+             g_sleep_state.wake_count, cause == ESP_SLEEP_WAKEUP_TIMER ? "timer" : "button",
+             g_site_name, g_sleep_state.temperature);
+
+    if (cause == ESP_SLEEP_WAKEUP_TIMER) {
+        scheduled_refresh();
+        return true;
+    }
+
+    int pin = sleep_wake_gpio();
+    sleep_release_wake_pins();
+
+    if (pin == CONFIG_ROT_UP_PIN) {
+        change_site(1);
+    } else if (pin == CONFIG_ROT_DOWN_PIN) {
+        change_site(-1);
+    } else if (pin == CONFIG_BTN_FETCH_PIN) {
+        fetch_and_display();
+    } else if (pin == CONFIG_BTN_MENU_PIN) {
+        fetch_all_and_display();
+    } else {
+        // EXIT stays awake for interactive use until the idle timeout
+        ESP_LOGI(TAG, "Woken by EXIT button, staying awake");
+        return false;
+    }
+
+    return true;
+}
+
+static void scheduled_refresh(void)
+{
+    int64_t interval = (int64_t)CONFIG_SLEEP_REFRESH_INTERVAL_MIN * 60;
+    int64_t elapsed = (int64_t)time(NULL) - g_sleep_state.last_refresh;
+
+    // The RTC slow clock drifts, a wake well before the deadline just sleeps again
+    if (g_sleep_state.last_refresh != 0 && elapsed >= 0 && elapsed < interval - SLEEP_MIN_SEC) {
+        ESP_LOGI(TAG, "Refresh not due for %" PRId64 " s", interval - elapsed);
+        return;
+    }
+
+    int site = g_current_site_index;
+    int64_t start_time = esp_timer_get_time();
+
+    // On failure the old screen stays up and the next interval retries
+    if (wifi_connect() != ESP_OK) {
+        ESP_LOGW(TAG, "WiFi connection failed, keeping current screen");
+        return;
+    }
+
+    setup_time();
+    if (!update_local_time() || !fetch_site_readings(site, false)) {
+        ESP_LOGW(TAG, "Scheduled fetch failed, keeping current screen");
+        return;
+    }
+
+    site_readings_t* readings = s_site_cache[site].readings;
+    if (readings == NULL || readings->count == 0) {
+        ESP_LOGW(TAG, "Scheduled fetch returned no readings, keeping current screen");
+        return;
+    }
+
+    int32_t previous_dt = (site < SLEEP_MAX_SITES) ? g_sleep_state.last_fetch_dt[site] : 0;
+    g_sleep_state.last_refresh = time(NULL);
+    g_data_loaded = true;
+    save_current_site_data(site);
+
+    // The panel keeps its image without power, only redraw on new readings
+    int32_t newest_dt = readings->dt[readings->count - 1];
+    if (newest_dt == previous_dt) {
+        ESP_LOGI(TAG, "No new readings for %s, screen unchanged", g_site_name);
+    } else {
+        display_site_data();
+    }
+
+    ESP_LOGI(TAG, "Scheduled refresh took %" PRId64 " ms",
+             (esp_timer_get_time() - start_time) / 1000);
+}
+
+static void enter_deep_sleep(void)
+{
+    g_sleep_state.site_index = g_current_site_index;
+    if (g_data_loaded && g_current_reading.dt != 0) {
+        g_sleep_state.temperature = g_current_reading.temperature;
+        g_sleep_state.water_temp = g_current_reading.water_temp;
+        g_sleep_state.pressure = g_current_reading.pressure;
+    }
+
+    // Sleep until the next refresh is due
+    int64_t interval = (int64_t)CONFIG_SLEEP_REFRESH_INTERVAL_MIN * 60;
+    int64_t elapsed = (int64_t)time(NULL) - g_sleep_state.last_refresh;
+    int64_t sleep_sec = interval;
+    if (g_sleep_state.last_refresh != 0 && elapsed >= 0 && elapsed < interval) {
+        sleep_sec = interval - elapsed;
+    }
+    if (sleep_sec < SLEEP_MIN_SEC) {
+        sleep_sec = SLEEP_MIN_SEC;
+    }
+
+    wifi_stop();
+    display_power_off();
+    sleep_enter_deep((uint32_t)sleep_sec);
+}
+#endif
+
 static bool s_sntp_initialized = false;
 
 static void time_sync_notification_cb(struct timeval* tv)
@@ -508,6 +785,14 @@ static void setup_time(void)
         s_sntp_initialized = true;
     }
 
+    // The RTC keeps time through deep sleep, only wait when it was lost
+    time_t now = time(NULL);
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    if (timeinfo.tm_year >= (2020 - 1900)) {
+        return;
+    }
+
     // Wait for time to sync (max 10 seconds)
     int retry = 0;
     while (esp_sntp_get_sync_status() == SNTP_SYNC_STATUS_RESET && ++retry < 20) {
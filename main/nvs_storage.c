@@ -3,6 +3,7 @@
  * @brief NVS storage implementation
  */
 
+#include <string.h>
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "esp_log.h"
@@ -13,6 +14,7 @@ static const char* TAG = "nvs_storage";
 static const char* NVS_NAMESPACE = "site";
 static const char* KEY_SITE_INDEX = "index";
 static const char* KEY_FIRST_BOOT = "first_boot";
+static const char* KEY_WIFI_AP = "wifi_ap";
 
 esp_err_t nvs_storage_init(void)
 {
@@ -168,3 +170,60 @@ esp_err_t nvs_clear_first_boot(void)
     nvs_close(handle);
     return ret;
 }
+
+esp_err_t nvs_save_wifi_ap(const uint8_t* bssid, uint8_t channel)
+{
+    nvs_handle_t handle;
+    esp_err_t ret;
+
+    ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // BSSID followed by channel
+    uint8_t blob[7];
+    memcpy(blob, bssid, 6);
+    blob[6] = channel;
+
+    ret = nvs_set_blob(handle, KEY_WIFI_AP, blob, sizeof(blob));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write WiFi AP: %s", esp_err_to_name(ret));
+    } else {
+        ESP_LOGD(TAG, "Saved WiFi AP (channel %d)", channel);
+    }
+
+    nvs_close(handle);
+    return ret;
+}
+
+esp_err_t nvs_load_wifi_ap(uint8_t* bssid, uint8_t* channel)
+{
+    nvs_handle_t handle;
+    esp_err_t ret;
+
+    ret = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    uint8_t blob[7];
+    size_t len = sizeof(blob);
+    ret = nvs_get_blob(handle, KEY_WIFI_AP, blob, &len);
+    if (ret == ESP_OK && len != sizeof(blob)) {
+        ret = ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    if (ret == ESP_OK) {
+        memcpy(bssid, blob, 6);
+        *channel = blob[6];
+    } else if (ret != ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGE(TAG, "Failed to read WiFi AP: %s", esp_err_to_name(ret));
+    }
+
+    nvs_close(handle);
+    return ret;
+}
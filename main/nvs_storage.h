@@ -6,6 +6,8 @@
 #ifndef NVS_STORAGE_H
 #define NVS_STORAGE_H
 
+#include <stdint.h>
+#include <stdbool.h>
 #include "esp_err.h"
 
 /**
@@ -40,4 +42,20 @@ bool nvs_is_first_boot(void);
  */
 esp_err_t nvs_clear_first_boot(void);
 
+/**
+ * @brief Save the access point of the last successful WiFi connection
+ * @param bssid BSSID (6 bytes)
+ * @param channel Primary channel
+ * @return ESP_OK on success
+ */
+esp_err_t nvs_save_wifi_ap(const uint8_t* bssid, uint8_t channel);
+
+/**
+ * @brief Load the access point of the last successful WiFi connection
+ * @param bssid Pointer to store BSSID (6 bytes)
+ * @param channel Pointer to store primary channel
+ * @return ESP_OK on success, ESP_ERR_NVS_NOT_FOUND if not set
+ */
+esp_err_t nvs_load_wifi_ap(uint8_t* bssid, uint8_t* channel);
+
 #endif // NVS_STORAGE_H
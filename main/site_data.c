@@ -1,14 +1,15 @@
 /**
  * @file site_data.c
- * @brief Site data structures and JSON parsing implementation
+ * @brief Site data structures and streaming JSON parser implementation
  */
 
 #include <string.h>
+#include <strings.h>
+#include <stdlib.h>
 #include <math.h>
 #include <time.h>
 #include <inttypes.h>
 #include "esp_log.h"
-#include "cJSON.h"
 #include "site_data.h"
 
 static const char* TAG = "site_data";
@@ -16,8 +17,7 @@ static const char* TAG = "site_data";
 // Global site data
 site_info_t g_site_info = {0};
 site_reading_t g_current_reading = {0};
-site_reading_t g_site_readings[MAX_READINGS] = {0};
-int g_num_readings = 0;
+site_readings_t* g_site_readings = NULL;
 
 // Site list for rotation
 const char* g_site_list[] = {
@@ -38,119 +38,681 @@ void convert_unix_time(int32_t unix_time, char* output, size_t output_len)
     strftime(output, output_len, "%H:%M %d/%m/%y", time_info);
 }
 
-bool parse_site_data(const char* json_str, bool print)
+// Streaming parser lexer states
+enum {
+    SP_VALUE,           // Expecting any value
+    SP_ARRAY_START,     // After '[': value or ']'
+    SP_OBJECT_START,    // After '{': key or '}'
+    SP_KEY,             // After ',' in an object: key
+    SP_COLON,           // After a key: ':'
+    SP_AFTER_VALUE,     // ',' or closing bracket
+    SP_STRING,
+    SP_STRING_ESC,
+    SP_STRING_HEX,
+    SP_NUMBER,
+    SP_LITERAL,
+    SP_DONE,
+    SP_ERROR,
+};
+
+// Container contexts, decide where scalar values are stored
+enum {
+    SP_CTX_SKIP,
+    SP_CTX_ROOT,
+    SP_CTX_CURRENT,
+    SP_CTX_READINGS,
+    SP_CTX_READING,
+};
+
+#define SP_CTX_ARRAY 0x80   // Flag set on ctx[] entries for arrays
+
+static void sp_fail(site_parser_t* p)
 {
-    cJSON* root = cJSON_Parse(json_str);
-    if (root == NULL) {
-        const char* error_ptr = cJSON_GetErrorPtr();
-        if (error_ptr != NULL) {
-            ESP_LOGE(TAG, "JSON parse error: %s", error_ptr);
-        }
-        return false;
+    if (p->state != SP_ERROR) {
+        ESP_LOGE(TAG, "JSON parse error at byte %u", (unsigned)p->offset);
+        p->state = SP_ERROR;
     }
+}
 
-    // Parse site metadata
-    cJSON* site_name = cJSON_GetObjectItem(root, "site_name");
-    if (cJSON_IsString(site_name)) {
-        strncpy(g_site_info.site_name, site_name->valuestring, MAX_SITE_NAME_LEN - 1);
+static uint8_t sp_top(const site_parser_t* p)
+{
+    return (p->depth > 0) ? p->ctx[p->depth - 1] : SP_CTX_SKIP;
+}
+
+static bool sp_key_is(const site_parser_t* p, const char* name)
+{
+    // cJSON_GetObjectItem compares keys case-insensitively
+    return strcasecmp(p->key, name) == 0;
+}
+
+// Same saturation as cJSON's valueint
+static int32_t sp_to_int(double value)
+{
+    if (value >= INT32_MAX) return INT32_MAX;
+    if (value <= (double)INT32_MIN) return INT32_MIN;
+    return (int32_t)value;
+}
+
+static void sp_token_reset(site_parser_t* p)
+{
+    p->token_len = 0;
+    p->token[0] = '\0';
+}
+
+static void sp_token_putc(site_parser_t* p, char c)
+{
+    // Keep counting past the buffer so oversized keys can be rejected
+    if (p->token_len < SITE_PARSER_TOKEN_LEN - 1) {
+        p->token[p->token_len] = c;
+        p->token[p->token_len + 1] = '\0';
     }
+    p->token_len++;
+}
 
-    cJSON* site_type = cJSON_GetObjectItem(root, "site_type");
-    if (cJSON_IsString(site_type)) {
-        strncpy(g_site_info.site_type, site_type->valuestring, sizeof(g_site_info.site_type) - 1);
+static bool sp_put_code_unit(site_parser_t* p)
+{
+    uint32_t cp = p->hex;
+
+    if (p->surrogate != 0) {
+        if (cp < 0xDC00 || cp > 0xDFFF) return false;
+        cp = 0x10000 + (((uint32_t)p->surrogate - 0xD800) << 10) + (cp - 0xDC00);
+        p->surrogate = 0;
+    } else if (cp >= 0xD800 && cp <= 0xDBFF) {
+        p->surrogate = (uint16_t)cp;  // Low half must follow as \uXXXX
+        return true;
+    } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+        return false;
     }
 
-    cJSON* active = cJSON_GetObjectItem(root, "active");
-    if (cJSON_IsBool(active)) {
-        g_site_info.active = cJSON_IsTrue(active);
+    if (cp < 0x80) {
+        sp_token_putc(p, (char)cp);
+    } else if (cp < 0x800) {
+        sp_token_putc(p, (char)(0xC0 | (cp >> 6)));
+        sp_token_putc(p, (char)(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        sp_token_putc(p, (char)(0xE0 | (cp >> 12)));
+        sp_token_putc(p, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        sp_token_putc(p, (char)(0x80 | (cp & 0x3F)));
+    } else {
+        sp_token_putc(p, (char)(0xF0 | (cp >> 18)));
+        sp_token_putc(p, (char)(0x80 | ((cp >> 12) & 0x3F)));
+        sp_token_putc(p, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        sp_token_putc(p, (char)(0x80 | (cp & 0x3F)));
     }
+    return true;
+}
+
+static void sp_value_done(site_parser_t* p)
+{
+    p->state = (p->depth == 0) ? SP_DONE : SP_AFTER_VALUE;
+}
 
-    cJSON* tz_offset = cJSON_GetObjectItem(root, "timezone_offset");
-    if (cJSON_IsNumber(tz_offset)) {
-        g_site_info.timezone_offset = tz_offset->valueint;
+// Copy the string token, cut to fit dst
+static void sp_copy_token(const site_parser_t* p, char* dst, size_t dst_len)
+{
+    size_t n = strnlen(p->token, dst_len - 1);
+    memcpy(dst, p->token, n);
+    dst[n] = '\0';
+}
+
+static void sp_store_string(site_parser_t* p)
+{
+    uint8_t ctx = sp_top(p);
+
+    if (ctx == SP_CTX_ROOT) {
+        if (sp_key_is(p, "site_name")) {
+            sp_copy_token(p, p->info.site_name, sizeof(p->info.site_name));
+        } else if (sp_key_is(p, "site_type")) {
+            sp_copy_token(p, p->info.site_type, sizeof(p->info.site_type));
+        }
     }
+    // Reading "timestamp" strings are skipped, they are formatted from dt
+}
 
-    cJSON* query_time = cJSON_GetObjectItem(root, "query_time");
-    if (cJSON_IsNumber(query_time)) {
-        g_site_info.query_time = query_time->valueint;
+static void sp_store_number(site_parser_t* p, double value)
+{
+    uint8_t ctx = sp_top(p);
+
+    if (ctx == SP_CTX_ROOT) {
+        if (sp_key_is(p, "timezone_offset")) p->info.timezone_offset = sp_to_int(value);
+        else if (sp_key_is(p, "query_time")) p->info.query_time = sp_to_int(value);
+    } else if (ctx == SP_CTX_CURRENT) {
+        site_reading_t* r = &p->current;
+        if (sp_key_is(p, "dt")) r->dt = sp_to_int(value);
+        else if (sp_key_is(p, "temperature")) r->temperature = (float)value;
+        else if (sp_key_is(p, "water_temp")) r->water_temp = (float)value;
+        else if (sp_key_is(p, "pressure")) r->pressure = (float)value;
+        else if (sp_key_is(p, "voltage")) r->voltage = (float)value;
+        else if (sp_key_is(p, "counter")) r->counter = sp_to_int(value);
+    } else if (ctx == SP_CTX_READING && p->reading_count <= MAX_READINGS) {
+        // reading_count includes the object being parsed
+        site_readings_t* r = p->readings;
+        int i = p->reading_count - 1;
+        if (sp_key_is(p, "dt")) r->dt[i] = sp_to_int(value);
+        else if (sp_key_is(p, "temperature")) r->temperature[i] = (float)value;
+        else if (sp_key_is(p, "water_temp")) r->water_temp[i] = (float)value;
+        else if (sp_key_is(p, "pressure")) r->pressure[i] = (float)value;
+        else if (sp_key_is(p, "voltage")) r->voltage[i] = (float)value;
+        else if (sp_key_is(p, "counter")) r->counter[i] = sp_to_int(value);
     }
+}
 
-    // Parse current reading
-    cJSON* current = cJSON_GetObjectItem(root, "current");
-    if (current != NULL) {
-        cJSON* item;
+static void sp_string_end(site_parser_t* p)
+{
+    if (p->is_key) {
+        // Keys longer than any known field are left unmatched
+        if (p->token_len < (int)sizeof(p->key)) {
+            memcpy(p->key, p->token, p->token_len + 1);
+        } else {
+            p->key[0] = '\0';
+        }
+        p->state = SP_COLON;
+        return;
+    }
+    sp_store_string(p);
+    sp_value_done(p);
+}
 
-        item = cJSON_GetObjectItem(current, "dt");
-        if (cJSON_IsNumber(item)) g_current_reading.dt = item->valueint;
+static bool sp_number_end(site_parser_t* p)
+{
+    char* end;
+    double value = strtod(p->token, &end);
+    if (end == p->token || *end != '\0') return false;
+
+    sp_store_number(p, value);
+    sp_value_done(p);
+    return true;
+}
 
-        item = cJSON_GetObjectItem(current, "timestamp");
-        if (cJSON_IsString(item)) {
-            strncpy(g_current_reading.timestamp, item->valuestring, MAX_TIMESTAMP_LEN - 1);
+static bool sp_literal_end(site_parser_t* p)
+{
+    if (strcmp(p->token, "true") == 0 || strcmp(p->token, "false") == 0) {
+        if (sp_top(p) == SP_CTX_ROOT && sp_key_is(p, "active")) {
+            p->info.active = (p->token[0] == 't');
         }
+    } else if (strcmp(p->token, "null") != 0) {
+        return false;
+    }
+    sp_value_done(p);
+    return true;
+}
+
+static void reverse_readings(site_readings_t* r)
+{
+    for (int i = 0, j = r->count - 1; i < j; i++, j--) {
+        int32_t dt = r->dt[i];
+        r->dt[i] = r->dt[j];
+        r->dt[j] = dt;
+
+        float temperature = r->temperature[i];
+        r->temperature[i] = r->temperature[j];
+        r->temperature[j] = temperature;
+
+        float water_temp = r->water_temp[i];
+        r->water_temp[i] = r->water_temp[j];
+        r->water_temp[j] = water_temp;
+
+        float pressure = r->pressure[i];
+        r->pressure[i] = r->pressure[j];
+        r->pressure[j] = pressure;
+
+        float voltage = r->voltage[i];
+        r->voltage[i] = r->voltage[j];
+        r->voltage[j] = voltage;
+
+        int32_t counter = r->counter[i];
+        r->counter[i] = r->counter[j];
+        r->counter[j] = counter;
+    }
+}
 
-        item = cJSON_GetObjectItem(current, "temperature");
-        if (cJSON_IsNumber(item)) g_current_reading.temperature = (float)item->valuedouble;
+static void sp_open(site_parser_t* p, char c)
+{
+    uint8_t parent = sp_top(p);
+    uint8_t ctx = SP_CTX_SKIP;
 
-        item = cJSON_GetObjectItem(current, "water_temp");
-        if (cJSON_IsNumber(item)) g_current_reading.water_temp = (float)item->valuedouble;
+    if (p->depth >= SITE_PARSER_MAX_DEPTH) {
+        sp_fail(p);
+        return;
+    }
 
-        item = cJSON_GetObjectItem(current, "pressure");
-        if (cJSON_IsNumber(item)) g_current_reading.pressure = (float)item->valuedouble;
+    if (p->depth == 0) {
+        if (c == '{') ctx = SP_CTX_ROOT;
+    } else if (parent == SP_CTX_ROOT && c == '{' && sp_key_is(p, "current")) {
+        ctx = SP_CTX_CURRENT;
+    } else if (parent == SP_CTX_ROOT && c == '[' && sp_key_is(p, "readings")) {
+        ctx = SP_CTX_READINGS;
+        p->reading_count = 0;
+    } else if (parent == (SP_CTX_READINGS | SP_CTX_ARRAY) && c == '{') {
+        ctx = SP_CTX_READING;
+    }
 
-        item = cJSON_GetObjectItem(current, "voltage");
-        if (cJSON_IsNumber(item)) g_current_reading.voltage = (float)item->valuedouble;
+    if (c == '[') {
+        p->ctx[p->depth++] = ctx | SP_CTX_ARRAY;
+        p->state = SP_ARRAY_START;
+    } else {
+        p->ctx[p->depth++] = ctx;
+        p->state = SP_OBJECT_START;
+    }
+}
 
-        item = cJSON_GetObjectItem(current, "counter");
-        if (cJSON_IsNumber(item)) g_current_reading.counter = item->valueint;
+static void sp_close(site_parser_t* p, char c)
+{
+    uint8_t ctx = sp_top(p);
+    bool is_array = (ctx & SP_CTX_ARRAY) != 0;
+
+    if (p->depth == 0 || is_array != (c == ']')) {
+        sp_fail(p);
+        return;
     }
+    p->depth--;
 
-    // Parse historical readings array
-    cJSON* readings = cJSON_GetObjectItem(root, "readings");
-    if (cJSON_IsArray(readings)) {
-        int array_size = cJSON_GetArraySize(readings);
-        g_num_readings = (array_size < MAX_READINGS) ? array_size : MAX_READINGS;
+    if ((ctx & ~SP_CTX_ARRAY) == SP_CTX_READINGS) {
+        // The API sends newest first, the store keeps oldest first
+        p->readings->count = (p->reading_count < MAX_READINGS) ? p->reading_count : MAX_READINGS;
+        reverse_readings(p->readings);
+    }
+    sp_value_done(p);
+}
 
-        for (int r = 0; r < g_num_readings; r++) {
-            cJSON* reading = cJSON_GetArrayItem(readings, r);
-            if (reading == NULL) continue;
+static void sp_begin_value(site_parser_t* p, char c)
+{
+    if (sp_top(p) == (SP_CTX_READINGS | SP_CTX_ARRAY)) {
+        p->reading_count++;
+    }
 
-            cJSON* item;
+    if (c == '{' || c == '[') {
+        sp_open(p, c);
+    } else if (c == '"') {
+        p->is_key = false;
+        sp_token_reset(p);
+        p->state = SP_STRING;
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+        sp_token_reset(p);
+        sp_token_putc(p, c);
+        p->state = SP_NUMBER;
+    } else if (c == 't' || c == 'f' || c == 'n') {
+        sp_token_reset(p);
+        sp_token_putc(p, c);
+        p->state = SP_LITERAL;
+    } else {
+        sp_fail(p);
+    }
+}
 
-            item = cJSON_GetObjectItem(reading, "dt");
-            if (cJSON_IsNumber(item)) g_site_readings[r].dt = item->valueint;
+// Handle a character outside of any string, number or literal
+static void sp_structural(site_parser_t* p, char c)
+{
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') return;
 
-            item = cJSON_GetObjectItem(reading, "timestamp");
-            if (cJSON_IsString(item)) {
-                strncpy(g_site_readings[r].timestamp, item->valuestring, MAX_TIMESTAMP_LEN - 1);
+    switch (p->state) {
+        case SP_ARRAY_START:
+            if (c == ']') {
+                sp_close(p, c);
+                return;
             }
+            // fall through
+        case SP_VALUE:
+            sp_begin_value(p, c);
+            return;
+
+        case SP_OBJECT_START:
+            if (c == '}') {
+                sp_close(p, c);
+                return;
+            }
+            // fall through
+        case SP_KEY:
+            if (c == '"') {
+                p->is_key = true;
+                sp_token_reset(p);
+                p->state = SP_STRING;
+                return;
+            }
+            break;
 
-            item = cJSON_GetObjectItem(reading, "temperature");
-            if (cJSON_IsNumber(item)) g_site_readings[r].temperature = (float)item->valuedouble;
+        case SP_COLON:
+            if (c == ':') {
+                p->state = SP_VALUE;
+                return;
+            }
+            break;
 
-            item = cJSON_GetObjectItem(reading, "water_temp");
-            if (cJSON_IsNumber(item)) g_site_readings[r].water_temp = (float)item->valuedouble;
+        case SP_AFTER_VALUE:
+            if (c == ',') {
+                p->state = (sp_top(p) & SP_CTX_ARRAY) ? SP_VALUE : SP_KEY;
+                return;
+            }
+            if (c == '}' || c == ']') {
+                sp_close(p, c);
+                return;
+            }
+            break;
+
+        case SP_DONE:
+            // Trailing data after the document is ignored, as cJSON_Parse does
+            return;
+    }
+    sp_fail(p);
+}
+
+static int sp_hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void site_parser_init(site_parser_t* parser, site_readings_t* readings)
+{
+    memset(parser, 0, sizeof(*parser));
+    parser->state = SP_VALUE;
+    parser->readings = readings;
+    // Fields missing from the response keep their current values
+    parser->info = g_site_info;
+    parser->current = g_current_reading;
+}
 
-            item = cJSON_GetObjectItem(reading, "pressure");
-            if (cJSON_IsNumber(item)) g_site_readings[r].pressure = (float)item->valuedouble;
+bool site_parser_feed(site_parser_t* p, const char* data, size_t len)
+{
+    for (size_t i = 0; i < len && p->state != SP_ERROR; i++, p->offset++) {
+        char c = data[i];
+
+        switch (p->state) {
+            case SP_STRING:
+                if (p->surrogate != 0 && c != '\\') {
+                    sp_fail(p);
+                } else if (c == '"') {
+                    sp_string_end(p);
+                } else if (c == '\\') {
+                    p->state = SP_STRING_ESC;
+                } else {
+                    sp_token_putc(p, c);
+                }
+                break;
+
+            case SP_STRING_ESC:
+                p->state = SP_STRING;
+                if (p->surrogate != 0 && c != 'u') {
+                    sp_fail(p);
+                    break;
+                }
+                switch (c) {
+                    case '"':
+                    case '\\':
+                    case '/': sp_token_putc(p, c); break;
+                    case 'b': sp_token_putc(p, '\b'); break;
+                    case 'f': sp_token_putc(p, '\f'); break;
+                    case 'n': sp_token_putc(p, '\n'); break;
+                    case 'r': sp_token_putc(p, '\r'); break;
+                    case 't': sp_token_putc(p, '\t'); break;
+                    case 'u':
+                        p->hex = 0;
+                        p->hex_digits = 0;
+                        p->state = SP_STRING_HEX;
+                        break;
+                    default:
+                        sp_fail(p);
+                        break;
+                }
+                break;
+
+            case SP_STRING_HEX: {
+                int v = sp_hex_value(c);
+                if (v < 0) {
+                    sp_fail(p);
+                    break;
+                }
+                p->hex = (p->hex << 4) | (uint32_t)v;
+                if (++p->hex_digits == 4) {
+                    if (sp_put_code_unit(p)) {
+                        p->state = SP_STRING;
+                    } else {
+                        sp_fail(p);
+                    }
+                }
+                break;
+            }
 
-            item = cJSON_GetObjectItem(reading, "voltage");
-            if (cJSON_IsNumber(item)) g_site_readings[r].voltage = (float)item->valuedouble;
+            case SP_NUMBER:
+                if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' ||
+                    c == '+' || c == '-') {
+                    sp_token_putc(p, c);
+                } else if (sp_number_end(p)) {
+                    sp_structural(p, c);
+                } else {
+                    sp_fail(p);
+                }
+                break;
+
+            case SP_LITERAL:
+                if (c >= 'a' && c <= 'z') {
+                    sp_token_putc(p, c);
+                } else if (sp_literal_end(p)) {
+                    sp_structural(p, c);
+                } else {
+                    sp_fail(p);
+                }
+                break;
+
+            default:
+                sp_structural(p, c);
+                break;
+        }
+    }
+    return p->state != SP_ERROR;
+}
+
+bool site_parser_finish(site_parser_t* p, bool print)
+{
+    // A bare top-level number or literal has no terminating character
+    if (p->state == SP_NUMBER && p->depth == 0 && !sp_number_end(p)) sp_fail(p);
+    if (p->state == SP_LITERAL && p->depth == 0 && !sp_literal_end(p)) sp_fail(p);
 
-            item = cJSON_GetObjectItem(reading, "counter");
-            if (cJSON_IsNumber(item)) g_site_readings[r].counter = item->valueint;
+    if (p->state != SP_DONE) {
+        if (p->state != SP_ERROR) {
+            ESP_LOGE(TAG, "JSON truncated after %u bytes", (unsigned)p->offset);
         }
+        return false;
     }
 
-    cJSON_Delete(root);
+    // Only a complete document replaces the site shown on screen
+    g_site_info = p->info;
+    g_current_reading = p->current;
 
     if (print) {
         ESP_LOGI(TAG, "Site: %s | Readings: %d | Current: %.1fC",
-                 g_site_info.site_name, g_num_readings, g_current_reading.temperature);
+                 g_site_info.site_name, p->readings->count, g_current_reading.temperature);
+    }
+
+    return true;
+}
+
+bool parse_site_data(const char* json_str, site_readings_t* readings, bool print)
+{
+    site_parser_t parser;
+
+    site_parser_init(&parser, readings);
+    site_parser_feed(&parser, json_str, strlen(json_str));
+    return site_parser_finish(&parser, print);
+}
+
+static int16_t bin_i16(const uint8_t* p)
+{
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static uint16_t bin_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static int32_t bin_i32(const uint8_t* p)
+{
+    return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                     ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+static void bin_string(char* dst, const uint8_t* src, size_t field_len, size_t dst_len)
+{
+    size_t n = (field_len < dst_len - 1) ? field_len : dst_len - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+}
+
+bool parse_site_data_binary(const uint8_t* data, size_t len, site_readings_t* readings,
+                            bool print)
+{
+    if (len < SITE_BIN_HEADER_LEN || memcmp(data, SITE_BIN_MAGIC, 4) != 0) {
+        ESP_LOGE(TAG, "Binary response: bad header");
+        return false;
+    }
+    if (data[4] != SITE_BIN_VERSION) {
+        ESP_LOGE(TAG, "Binary response: unsupported version %d", data[4]);
+        return false;
+    }
+
+    int n = bin_u16(&data[6]);
+    if (len < (size_t)SITE_BIN_SIZE(n)) {
+        ESP_LOGE(TAG, "Binary response truncated: %u of %u bytes",
+                 (unsigned)len, (unsigned)SITE_BIN_SIZE(n));
+        return false;
+    }
+
+    float scale[4];
+    for (int i = 0; i < 4; i++) {
+        uint16_t q = bin_u16(&data[16 + i * 2]);
+        scale[i] = (q != 0) ? (float)q : 1.0f;
+    }
+
+    // Site metadata and current reading, committed once the body is valid
+    site_info_t info = {0};
+    info.active = (data[5] != 0);
+    info.timezone_offset = bin_i32(&data[8]);
+    info.query_time = bin_i32(&data[12]);
+    bin_string(info.site_type, &data[24], 16, sizeof(info.site_type));
+    bin_string(info.site_name, &data[40], 32, sizeof(info.site_name));
+
+    site_reading_t current;
+    const uint8_t* p = &data[72];
+    current.dt = bin_i32(p);
+    current.temperature = bin_i16(p + 4) / scale[0];
+    current.water_temp = bin_i16(p + 6) / scale[1];
+    current.pressure = bin_i16(p + 8) / scale[2];
+    current.voltage = bin_i16(p + 10) / scale[3];
+    current.counter = bin_i32(p + 12);
+
+    // Historical columns, decoded up to MAX_READINGS
+    int count = (n < MAX_READINGS) ? n : MAX_READINGS;
+    const uint8_t* end = data + len;
+    const uint8_t* dt_col = &data[SITE_BIN_HEADER_LEN];
+
+    // Columns are sent newest first, the store keeps oldest first.
+    // Escaped gaps make the dt column variable length, so walk all of it
+    // to find the columns behind it.
+    const uint8_t* s = dt_col;
+    int32_t dt = 0;
+    for (int r = 0; r < n; r++) {
+        int32_t next;
+        if (r == 0) {
+            next = bin_i32(s);
+            s += 4;
+        } else {
+            uint16_t gap = bin_u16(s);
+            s += 2;
+            if (gap == SITE_BIN_DT_ESCAPE) {
+                if (end - s < 4 + (n - 1 - r) * 2 + 12 * n) {
+                    ESP_LOGE(TAG, "Binary response truncated in dt column");
+                    return false;
+                }
+                next = bin_i32(s);
+                s += 4;
+            } else {
+                next = (int32_t)((int64_t)dt - gap);
+            }
+            // Readings must be strictly older than the one before
+            if (gap == 0 || (int64_t)next >= dt) {
+                ESP_LOGE(TAG, "Binary response: bad dt at reading %d", r);
+                return false;
+            }
+        }
+        dt = next;
+        if (r < count) {
+            readings->dt[count - 1 - r] = dt;
+        }
+    }
+
+    const uint8_t* temp_col = s;
+    const uint8_t* water_col = temp_col + 2 * n;
+    const uint8_t* pressure_col = water_col + 2 * n;
+    const uint8_t* voltage_col = pressure_col + 2 * n;
+    const uint8_t* counter_col = voltage_col + 2 * n;
+
+    for (int r = 0; r < count; r++) {
+        int i = count - 1 - r;
+
+        readings->temperature[i] = bin_i16(&temp_col[2 * r]) / scale[0];
+        readings->water_temp[i] = bin_i16(&water_col[2 * r]) / scale[1];
+        readings->pressure[i] = bin_i16(&pressure_col[2 * r]) / scale[2];
+        readings->voltage[i] = bin_i16(&voltage_col[2 * r]) / scale[3];
+        readings->counter[i] = bin_i32(&counter_col[4 * r]);
+    }
+    readings->count = count;
+    g_site_info = info;
+    g_current_reading = current;
+
+    if (print) {
+        ESP_LOGI(TAG, "Site: %s | Readings: %d | Current: %.1fC (binary)",
+                 g_site_info.site_name, readings->count, g_current_reading.temperature);
     }
 
     return true;
 }
 
+int merge_site_readings(site_readings_t* dst, const site_readings_t* delta,
+                        int32_t since, int max_readings)
+{
+    if (max_readings > MAX_READINGS) max_readings = MAX_READINGS;
+
+    // Only the trailing run is new, anything at or before since is a duplicate
+    int first_new = delta->count;
+    while (first_new > 0 && delta->dt[first_new - 1] > since) {
+        first_new--;
+    }
+    int added = delta->count - first_new;
+    if (added > max_readings) {
+        first_new += added - max_readings;
+        added = max_readings;
+    }
+
+    // Slide the window left to make room, dropping the oldest readings
+    int drop = dst->count + added - max_readings;
+    if (drop < 0) drop = 0;
+    if (drop > dst->count) drop = dst->count;
+    int keep = dst->count - drop;
+
+    if (drop > 0) {
+        memmove(dst->dt, &dst->dt[drop], sizeof(dst->dt[0]) * keep);
+        memmove(dst->temperature, &dst->temperature[drop], sizeof(dst->temperature[0]) * keep);
+        memmove(dst->water_temp, &dst->water_temp[drop], sizeof(dst->water_temp[0]) * keep);
+        memmove(dst->pressure, &dst->pressure[drop], sizeof(dst->pressure[0]) * keep);
+        memmove(dst->voltage, &dst->voltage[drop], sizeof(dst->voltage[0]) * keep);
+        memmove(dst->counter, &dst->counter[drop], sizeof(dst->counter[0]) * keep);
+    }
+
+    memcpy(&dst->dt[keep], &delta->dt[first_new], sizeof(dst->dt[0]) * added);
+    memcpy(&dst->temperature[keep], &delta->temperature[first_new], sizeof(dst->temperature[0]) * added);
+    memcpy(&dst->water_temp[keep], &delta->water_temp[first_new], sizeof(dst->water_temp[0]) * added);
+    memcpy(&dst->pressure[keep], &delta->pressure[first_new], sizeof(dst->pressure[0]) * added);
+    memcpy(&dst->voltage[keep], &delta->voltage[first_new], sizeof(dst->voltage[0]) * added);
+    memcpy(&dst->counter[keep], &delta->counter[first_new], sizeof(dst->counter[0]) * added);
+
+    dst->count = keep + added;
+
+    return added;
+}
+
 int julian_date(int d, int m, int y)
 {
     int mm, yy, k1, k2, k3, j;
@@ -181,7 +743,7 @@ double normalized_moon_phase(int d, int m, int y)
     return phase - (int)phase;
 }
 
-int aggregate_to_hourly(float* five_min_data, int num_readings, float* hourly_data)
+int aggregate_to_hourly(const float* five_min_data, int num_readings, float* hourly_data)
 {
     // 12 readings per hour (5-minute intervals)
     const int readings_per_hour = 12;
@@ -218,7 +780,7 @@ int aggregate_to_hourly(float* five_min_data, int num_readings, float* hourly_da
     return available_hours;
 }
 
-void aggregate_to_24_hours(float* five_min_data, int num_readings,
+void aggregate_to_24_hours(const float* five_min_data, int num_readings,
                            float* hourly_data, bool* has_data)
 {
     const int readings_per_hour = 12;  // 5-minute intervals
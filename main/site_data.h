@@ -8,16 +8,17 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #define MAX_READINGS 288  // 24 hours at 5-minute intervals
 #define MAX_HOURLY_READINGS 24  // 24 hours
+#define READING_INTERVAL_SEC 300  // 5-minute readings
 #define MAX_SITE_NAME_LEN 32
 #define MAX_TIMESTAMP_LEN 32
 
-// Site reading structure
+// Single reading (the "current" value of a site)
 typedef struct {
     int32_t dt;                         // Unix timestamp
-    char timestamp[MAX_TIMESTAMP_LEN];  // Human readable timestamp
     float temperature;                  // Ambient temperature
     float water_temp;                   // Water temperature
     float pressure;                     // Pressure reading
@@ -25,6 +26,18 @@ typedef struct {
     int32_t counter;                    // Reading counter
 } site_reading_t;
 
+// Reading history stored as columns, oldest first (count - 1 is newest).
+// Timestamps are not stored, format them from dt with convert_unix_time().
+typedef struct {
+    int32_t dt[MAX_READINGS];           // Unix timestamps
+    float temperature[MAX_READINGS];    // Ambient temperature
+    float water_temp[MAX_READINGS];     // Water temperature
+    float pressure[MAX_READINGS];       // Pressure readings
+    float voltage[MAX_READINGS];        // Battery/supply voltage
+    int32_t counter[MAX_READINGS];      // Reading counters
+    int count;                          // Number of valid readings
+} site_readings_t;
+
 // Site metadata structure
 typedef struct {
     char site_name[MAX_SITE_NAME_LEN];
@@ -34,11 +47,57 @@ typedef struct {
     int32_t query_time;
 } site_info_t;
 
+// Compact binary response (format=bin), all fields little-endian:
+//   0  char[4]  magic "SDB1"
+//   4  u8       version
+//   5  u8       active
+//   6  u16      number of readings (n)
+//   8  i32      timezone_offset
+//  12  i32      query_time
+//  16  u16[4]   scale of temperature, water_temp, pressure, voltage
+//  24  char[16] site_type (NUL padded)
+//  40  char[32] site_name (NUL padded)
+//  72  current reading: i32 dt, i16 x4 quantized columns, i32 counter
+//  88  readings, newest first: i32 dt[0], then for i > 0 the u16 gap
+//      dt[i-1] - dt[i] (1..65534), or SITE_BIN_DT_ESCAPE followed by i32
+//      dt[i] for longer gaps (a site that was offline),
+//      then i16 temperature[n], water_temp[n], pressure[n], voltage[n],
+//      then i32 counter[n]
+// A quantized value q decodes as q / scale.
+#define SITE_BIN_MAGIC "SDB1"
+#define SITE_BIN_VERSION 2
+#define SITE_BIN_HEADER_LEN 88
+#define SITE_BIN_DT_ESCAPE 0xFFFF
+// Size without escaped gaps, each escape adds 4 bytes
+#define SITE_BIN_SIZE(n) (SITE_BIN_HEADER_LEN + ((n) > 0 ? 4 + 2 * ((n) - 1) : 0) + 12 * (n))
+#define SITE_BIN_MAX_SIZE (SITE_BIN_SIZE(MAX_READINGS) + 4 * (MAX_READINGS - 1))
+
+#define SITE_PARSER_MAX_DEPTH 8
+#define SITE_PARSER_TOKEN_LEN 64
+
+// Incremental JSON parser state, fed chunk by chunk from the HTTP client
+typedef struct {
+    uint8_t state;                          // Lexer state
+    uint8_t depth;                          // Number of open containers
+    uint8_t ctx[SITE_PARSER_MAX_DEPTH];     // Context of each open container
+    bool is_key;                            // Current string is an object key
+    char key[16];                           // Most recent object key
+    char token[SITE_PARSER_TOKEN_LEN];      // String, number or literal text
+    int token_len;                          // Bytes seen (may exceed token)
+    uint32_t hex;                           // \uXXXX code unit being read
+    uint8_t hex_digits;
+    uint16_t surrogate;                     // Pending UTF-16 high surrogate
+    int reading_count;                      // Elements seen in "readings"
+    site_readings_t* readings;              // Destination of the "readings" array
+    site_info_t info;                       // Metadata, copied to g_site_info on success
+    site_reading_t current;                 // Copied to g_current_reading on success
+    size_t offset;                          // Bytes consumed (for errors)
+} site_parser_t;
+
 // Global site data
 extern site_info_t g_site_info;
 extern site_reading_t g_current_reading;
-extern site_reading_t g_site_readings[MAX_READINGS];
-extern int g_num_readings;
+extern site_readings_t* g_site_readings;   // Current site's readings (NULL if none)
 
 // Site list
 extern const char* g_site_list[];
@@ -52,10 +111,75 @@ extern const char* g_site_name;
 /**
  * @brief Parse JSON response from Site Data API
  * @param json_str JSON string to parse
+ * @param readings Destination for the historical readings
  * @param print If true, print parsed data to console
  * @return true on success, false on parse error
  */
-bool parse_site_data(const char* json_str, bool print);
+bool parse_site_data(const char* json_str, site_readings_t* readings, bool print);
+
+/**
+ * @brief Decode a compact binary response from Site Data API
+ *
+ * g_site_info and g_current_reading are only updated if the whole
+ * response is valid; the readings columns may be partially written.
+ *
+ * @param data Response body
+ * @param len Length of response body
+ * @param readings Destination for the historical readings
+ * @param print If true, print parsed data to console
+ * @return true on success, false if the response is malformed
+ */
+bool parse_site_data_binary(const uint8_t* data, size_t len, site_readings_t* readings,
+                            bool print);
+
+/**
+ * @brief Reset a streaming parser before the first chunk of a response
+ * @param parser Parser state
+ * @param readings Destination for the historical readings
+ */
+void site_parser_init(site_parser_t* parser, site_readings_t* readings);
+
+/**
+ * @brief Feed a chunk of the JSON response to the streaming parser
+ *
+ * Fields are stored as soon as they are complete, so chunks may be split
+ * anywhere. Readings go straight into the destination columns, which may
+ * be partially updated by a malformed response; the site metadata and
+ * current reading are held in the parser until site_parser_finish().
+ *
+ * @param parser Parser state
+ * @param data Chunk of response body
+ * @param len Length of chunk
+ * @return false once a syntax error has been seen
+ */
+bool site_parser_feed(site_parser_t* parser, const char* data, size_t len);
+
+/**
+ * @brief Finish parsing after the last chunk
+ *
+ * On success the site metadata and current reading are copied into
+ * g_site_info and g_current_reading; otherwise they are left untouched.
+ *
+ * @param parser Parser state
+ * @param print If true, print parsed data to console
+ * @return true if a complete JSON document was parsed
+ */
+bool site_parser_finish(site_parser_t* parser, bool print);
+
+/**
+ * @brief Merge readings from a delta response into a site's readings
+ *
+ * Readings in delta newer than since are appended behind the readings in
+ * dst, dropping the oldest to fit the window.
+ *
+ * @param dst Site readings to update in place
+ * @param delta Readings returned for a "since" request
+ * @param since Newest timestamp in dst
+ * @param max_readings Size of the sliding window
+ * @return Number of new readings added
+ */
+int merge_site_readings(site_readings_t* dst, const site_readings_t* delta,
+                        int32_t since, int max_readings);
 
 /**
  * @brief Convert Unix timestamp to formatted string
@@ -98,7 +222,7 @@ float sum_of_precip(float* data_array, int readings);
  * @param hourly_data Output array for 24 hourly averages
  * @return Number of hourly values created
  */
-int aggregate_to_hourly(float* five_min_data, int num_readings, float* hourly_data);
+int aggregate_to_hourly(const float* five_min_data, int num_readings, float* hourly_data);
 
 /**
  * @brief Aggregate to full 24 hours with NaN for missing hours
@@ -107,7 +231,7 @@ int aggregate_to_hourly(float* five_min_data, int num_readings, float* hourly_da
  * @param hourly_data Output array for 24 hourly values (oldest to newest)
  * @param has_data Output array indicating which hours have data
  */
-void aggregate_to_24_hours(float* five_min_data, int num_readings,
+void aggregate_to_24_hours(const float* five_min_data, int num_readings,
                            float* hourly_data, bool* has_data);
 
 #endif // SITE_DATA_H
@@ -0,0 +1,350 @@
+/**
+ * @file site_store.c
+ * @brief Flash-backed site cache implementation
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "esp_spiffs.h"
+#include "esp_rom_crc.h"
+
+#include "site_store.h"
+
+static const char* TAG = "site_store";
+
+#define SITE_STORE_MAX_SITES 16
+
+#define RECORD_MAGIC 0x31524453  // "SDR1"
+#define RECORD_SNAPSHOT 0        // Replaces everything before it
+#define RECORD_APPEND 1          // Readings newer than those before it
+
+// Record header, followed by the dt, temperature, water_temp, pressure,
+// voltage and counter columns (count entries each) and a CRC32 of both
+typedef struct {
+    uint32_t magic;
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t count;
+    char time_str[16];
+    char date_str[32];
+} record_header_t;
+
+#define RECORD_SIZE(n) (sizeof(record_header_t) + (n) * 24 + sizeof(uint32_t))
+
+// Appends stop and the file is compacted to one snapshot past this size
+#define MAX_FILE_SIZE (4 * RECORD_SIZE(MAX_READINGS))
+
+// What is known about each site's file, so saves can skip or append
+typedef struct {
+    bool known;             // Fields below reflect the file
+    bool needs_compact;     // File has a torn record and must be rewritten
+    int32_t newest_dt;      // Newest reading stored
+    long size;              // Bytes of valid records
+} store_state_t;
+
+static store_state_t s_state[SITE_STORE_MAX_SITES];
+
+static void store_path(char* path, size_t len, int site_index, const char* ext)
+{
+    snprintf(path, len, "%s/site%d.%s", SITE_STORE_BASE_PATH, site_index, ext);
+}
+
+static bool write_block(FILE* f, const void* data, size_t len, uint32_t* crc)
+{
+    *crc = esp_rom_crc32_le(*crc, (const uint8_t*)data, len);
+    return fwrite(data, 1, len, f) == len;
+}
+
+static bool read_block(FILE* f, void* data, size_t len, uint32_t* crc)
+{
+    if (fread(data, 1, len, f) != len) {
+        return false;
+    }
+    *crc = esp_rom_crc32_le(*crc, (const uint8_t*)data, len);
+    return true;
+}
+
+static bool write_record(FILE* f, uint8_t type, const site_readings_t* readings,
+                         int from, int count, const char* time_str, const char* date_str)
+{
+    record_header_t header = {
+        .magic = RECORD_MAGIC,
+        .type = type,
+        .count = (uint16_t)count,
+    };
+    strncpy(header.time_str, time_str, sizeof(header.time_str) - 1);
+    strncpy(header.date_str, date_str, sizeof(header.date_str) - 1);
+
+    uint32_t crc = 0;
+    bool ok = write_block(f, &header, sizeof(header), &crc) &&
+              write_block(f, &readings->dt[from], sizeof(int32_t) * count, &crc) &&
+              write_block(f, &readings->temperature[from], sizeof(float) * count, &crc) &&
+              write_block(f, &readings->water_temp[from], sizeof(float) * count, &crc) &&
+              write_block(f, &readings->pressure[from], sizeof(float) * count, &crc) &&
+              write_block(f, &readings->voltage[from], sizeof(float) * count, &crc) &&
+              write_block(f, &readings->counter[from], sizeof(int32_t) * count, &crc);
+
+    return ok && fwrite(&crc, 1, sizeof(crc), f) == sizeof(crc);
+}
+
+static bool read_record(FILE* f, record_header_t* header, site_readings_t* record)
+{
+    uint32_t crc = 0;
+    uint32_t stored_crc;
+
+    if (!read_block(f, header, sizeof(*header), &crc) ||
+        header->magic != RECORD_MAGIC || header->count > MAX_READINGS ||
+        (header->type != RECORD_SNAPSHOT && header->type != RECORD_APPEND)) {
+        return false;
+    }
+
+    int count = header->count;
+    bool ok = read_block(f, record->dt, sizeof(int32_t) * count, &crc) &&
+              read_block(f, record->temperature, sizeof(float) * count, &crc) &&
+              read_block(f, record->water_temp, sizeof(float) * count, &crc) &&
+              read_block(f, record->pressure, sizeof(float) * count, &crc) &&
+              read_block(f, record->voltage, sizeof(float) * count, &crc) &&
+              read_block(f, record->counter, sizeof(int32_t) * count, &crc);
+
+    if (!ok || fread(&stored_crc, 1, sizeof(stored_crc), f) != sizeof(stored_crc) ||
+        stored_crc != crc) {
+        return false;
+    }
+
+    header->time_str[sizeof(header->time_str) - 1] = '\0';
+    header->date_str[sizeof(header->date_str) - 1] = '\0';
+    record->count = count;
+    return true;
+}
+
+static int32_t newest_dt(const site_readings_t* readings)
+{
+    return (readings->count > 0) ? readings->dt[readings->count - 1] : 0;
+}
+
+esp_err_t site_store_init(void)
+{
+    esp_vfs_spiffs_conf_t conf = {
+        .base_path = SITE_STORE_BASE_PATH,
+        .partition_label = SITE_STORE_PARTITION,
+        .max_files = 4,
+        .format_if_mount_failed = true,
+    };
+
+    esp_err_t ret = esp_vfs_spiffs_register(&conf);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mount SPIFFS: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    size_t total = 0, used = 0;
+    esp_spiffs_info(SITE_STORE_PARTITION, &total, &used);
+    ESP_LOGI(TAG, "SPIFFS mounted: %u of %u bytes used", (unsigned)used, (unsigned)total);
+
+    return ESP_OK;
+}
+
+bool site_store_exists(int site_index)
+{
+    char path[32];
+    struct stat st;
+
+    store_path(path, sizeof(path), site_index, "dat");
+    if (stat(path, &st) == 0) {
+        return true;
+    }
+
+    // A compaction interrupted before its rename still holds a full snapshot
+    store_path(path, sizeof(path), site_index, "tmp");
+    return stat(path, &st) == 0;
+}
+
+esp_err_t site_store_load(int site_index, site_readings_t* readings,
+                          char* time_str, size_t time_len,
+                          char* date_str, size_t date_len)
+{
+    if (site_index < 0 || site_index >= SITE_STORE_MAX_SITES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    store_state_t* state = &s_state[site_index];
+    char path[32];
+    char tmp_path[32];
+    store_path(path, sizeof(path), site_index, "dat");
+    store_path(tmp_path, sizeof(tmp_path), site_index, "tmp");
+
+    FILE* f = fopen(path, "rb");
+    if (f == NULL && rename(tmp_path, path) == 0) {
+        ESP_LOGW(TAG, "Recovered interrupted compaction for site %d", site_index);
+        f = fopen(path, "rb");
+    }
+
+    readings->count = 0;
+    if (f == NULL) {
+        state->known = true;
+        state->needs_compact = false;
+        state->newest_dt = 0;
+        state->size = 0;
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    site_readings_t* record = (site_readings_t*)malloc(sizeof(site_readings_t));
+    if (record == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate record buffer");
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Replay the log, stopping at the first record that does not check out
+    record_header_t header;
+    long valid_size = 0;
+    int num_records = 0;
+    while (read_record(f, &header, record)) {
+        if (header.type == RECORD_SNAPSHOT) {
+            memcpy(readings, record, sizeof(site_readings_t));
+        } else {
+            merge_site_readings(readings, record, newest_dt(readings), MAX_READINGS);
+        }
+        strncpy(time_str, header.time_str, time_len - 1);
+        time_str[time_len - 1] = '\0';
+        strncpy(date_str, header.date_str, date_len - 1);
+        date_str[date_len - 1] = '\0';
+
+        valid_size = ftell(f);
+        num_records++;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    fclose(f);
+    free(record);
+
+    state->known = true;
+    state->needs_compact = (file_size != valid_size);
+    state->newest_dt = newest_dt(readings);
+    state->size = valid_size;
+
+    if (state->needs_compact) {
+        ESP_LOGW(TAG, "Site %d: ignored %ld bytes of torn data", site_index, file_size - valid_size);
+    }
+
+    if (num_records == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    ESP_LOGD(TAG, "Site %d: %d readings from %d records", site_index, readings->count, num_records);
+    return ESP_OK;
+}
+
+static esp_err_t write_snapshot(int site_index, const site_readings_t* readings,
+                                const char* time_str, const char* date_str)
+{
+    char path[32];
+    char tmp_path[32];
+    store_path(path, sizeof(path), site_index, "dat");
+    store_path(tmp_path, sizeof(tmp_path), site_index, "tmp");
+
+    // Write the new file completely before dropping the old one
+    FILE* f = fopen(tmp_path, "wb");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "Failed to create %s", tmp_path);
+        return ESP_FAIL;
+    }
+
+    bool ok = write_record(f, RECORD_SNAPSHOT, readings, 0, readings->count, time_str, date_str);
+    if (fclose(f) != 0 || !ok) {
+        ESP_LOGE(TAG, "Failed to write %s", tmp_path);
+        remove(tmp_path);
+        return ESP_FAIL;
+    }
+
+    // SPIFFS cannot rename over an existing file
+    remove(path);
+    if (rename(tmp_path, path) != 0) {
+        ESP_LOGE(TAG, "Failed to rename %s", tmp_path);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t append_record(int site_index, const site_readings_t* readings, int from,
+                               const char* time_str, const char* date_str)
+{
+    char path[32];
+    store_path(path, sizeof(path), site_index, "dat");
+
+    FILE* f = fopen(path, "ab");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        return ESP_FAIL;
+    }
+
+    bool ok = write_record(f, RECORD_APPEND, readings, from, readings->count - from,
+                           time_str, date_str);
+    if (fclose(f) != 0 || !ok) {
+        ESP_LOGE(TAG, "Failed to append to %s", path);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t site_store_save(int site_index, const site_readings_t* readings,
+                          const char* time_str, const char* date_str)
+{
+    if (site_index < 0 || site_index >= SITE_STORE_MAX_SITES ||
+        readings == NULL || readings->count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    store_state_t* state = &s_state[site_index];
+    bool has_file = state->known && state->size > 0;
+
+    // Avoid flash wear: write only when there are newer readings
+    if (has_file && newest_dt(readings) <= state->newest_dt) {
+        ESP_LOGD(TAG, "Site %d unchanged, not writing", site_index);
+        return ESP_OK;
+    }
+
+    // Append just the new tail if it continues the stored readings
+    int from = readings->count;
+    if (has_file) {
+        while (from > 0 && readings->dt[from - 1] > state->newest_dt) {
+            from--;
+        }
+    }
+
+    long size = RECORD_SIZE(readings->count - from);
+    bool append = has_file && !state->needs_compact && from > 0 &&
+                  state->size + size <= (long)MAX_FILE_SIZE;
+
+    esp_err_t ret;
+    if (append) {
+        ret = append_record(site_index, readings, from, time_str, date_str);
+        if (ret == ESP_OK) {
+            state->size += size;
+        }
+    } else {
+        ret = write_snapshot(site_index, readings, time_str, date_str);
+        if (ret == ESP_OK) {
+            state->size = RECORD_SIZE(readings->count);
+            state->needs_compact = false;
+        }
+    }
+
+    if (ret == ESP_OK) {
+        state->known = true;
+        state->newest_dt = newest_dt(readings);
+        ESP_LOGD(TAG, "Site %d: %s %d readings", site_index,
+                 append ? "appended" : "wrote snapshot of", readings->count - (append ? from : 0));
+    } else {
+        // Unknown file state, rewrite it next time
+        state->known = false;
+    }
+
+    return ret;
+}
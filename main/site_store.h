@@ -0,0 +1,66 @@
+/**
+ * @file site_store.h
+ * @brief Flash-backed site cache on the SPIFFS partition
+ *
+ * Each site has one file holding a log of checksummed records. The first
+ * record is a snapshot of the site's readings; later fetches append only
+ * the readings that are new, and the file is compacted back to a single
+ * snapshot once it grows too large. A torn final record is ignored on load.
+ */
+
+#ifndef SITE_STORE_H
+#define SITE_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "site_data.h"
+
+#ifndef SITE_STORE_BASE_PATH
+#define SITE_STORE_BASE_PATH "/cache"
+#endif
+#define SITE_STORE_PARTITION "spiffs"
+
+/**
+ * @brief Mount the SPIFFS partition used for the site cache
+ * @return ESP_OK on success
+ */
+esp_err_t site_store_init(void);
+
+/**
+ * @brief Check whether a site has data stored in flash
+ * @param site_index Site index
+ * @return true if a cache file exists for the site
+ */
+bool site_store_exists(int site_index);
+
+/**
+ * @brief Load a site's readings and fetch time from flash
+ * @param site_index Site index
+ * @param readings Destination for the readings
+ * @param time_str Destination for the fetch time string
+ * @param time_len Size of time_str
+ * @param date_str Destination for the fetch date string
+ * @param date_len Size of date_str
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if nothing valid is stored
+ */
+esp_err_t site_store_load(int site_index, site_readings_t* readings,
+                          char* time_str, size_t time_len,
+                          char* date_str, size_t date_len);
+
+/**
+ * @brief Persist a site's readings and fetch time
+ *
+ * Nothing is written unless there are readings newer than the ones
+ * already stored.
+ *
+ * @param site_index Site index
+ * @param readings Readings to store
+ * @param time_str Fetch time string
+ * @param date_str Fetch date string
+ * @return ESP_OK on success (including when nothing needed writing)
+ */
+esp_err_t site_store_save(int site_index, const site_readings_t* readings,
+                          const char* time_str, const char* date_str);
+
+#endif // SITE_STORE_H
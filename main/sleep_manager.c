@@ -0,0 +1,87 @@
+/**
+ * @file sleep_manager.c
+ * @brief Deep sleep scheduling implementation
+ */
+
+#include <string.h>
+#include <inttypes.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "driver/rtc_io.h"
+
+#include "sleep_manager.h"
+
+static const char* TAG = "sleep_manager";
+
+#define SLEEP_STATE_MAGIC 0x534C5031  // "SLP1"
+
+RTC_DATA_ATTR sleep_state_t g_sleep_state;
+
+// Buttons are active low with pull-ups, any of them wakes the chip
+static const int s_wake_pins[] = {
+    CONFIG_ROT_UP_PIN,
+    CONFIG_ROT_DOWN_PIN,
+    CONFIG_BTN_FETCH_PIN,
+    CONFIG_BTN_MENU_PIN,
+    CONFIG_BTN_EXIT_PIN,
+};
+
+#define NUM_WAKE_PINS ((int)(sizeof(s_wake_pins) / sizeof(s_wake_pins[0])))
+
+bool sleep_state_valid(void)
+{
+    return g_sleep_state.magic == SLEEP_STATE_MAGIC;
+}
+
+void sleep_state_reset(void)
+{
+    memset(&g_sleep_state, 0, sizeof(g_sleep_state));
+    g_sleep_state.magic = SLEEP_STATE_MAGIC;
+}
+
+int sleep_wake_gpio(void)
+{
+    if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_EXT1) {
+        return -1;
+    }
+
+    uint64_t status = esp_sleep_get_ext1_wakeup_status();
+    if (status == 0) {
+        return -1;
+    }
+    return __builtin_ctzll(status);
+}
+
+void sleep_release_wake_pins(void)
+{
+    // Pins stay routed to the RTC mux after an ext1 wake
+    for (int i = 0; i < NUM_WAKE_PINS; i++) {
+        rtc_gpio_deinit(s_wake_pins[i]);
+    }
+}
+
+void sleep_enter_deep(uint32_t sleep_sec)
+{
+    uint64_t pin_mask = 0;
+
+    for (int i = 0; i < NUM_WAKE_PINS; i++) {
+        pin_mask |= 1ULL << s_wake_pins[i];
+    }
+    esp_sleep_enable_ext1_wakeup(pin_mask, ESP_EXT1_WAKEUP_ANY_LOW);
+
+    // Digital pull-ups are off in deep sleep, keep the RTC ones powered
+    esp_sleep_pd_config(ESP_PD_DOMAIN_RTC_PERIPH, ESP_PD_OPTION_ON);
+    for (int i = 0; i < NUM_WAKE_PINS; i++) {
+        rtc_gpio_pullup_en(s_wake_pins[i]);
+        rtc_gpio_pulldown_dis(s_wake_pins[i]);
+    }
+
+    esp_sleep_enable_timer_wakeup((uint64_t)sleep_sec * 1000000ULL);
+
+    g_sleep_state.wake_count++;
+    ESP_LOGI(TAG, "Entering deep sleep for %" PRIu32 " s (wake #%" PRIu32 ")",
+             sleep_sec, g_sleep_state.wake_count);
+
+    esp_deep_sleep_start();
+}
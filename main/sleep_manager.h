@@ -0,0 +1,56 @@
+/**
+ * @file sleep_manager.h
+ * @brief Deep sleep scheduling and state retained in RTC memory
+ */
+
+#ifndef SLEEP_MANAGER_H
+#define SLEEP_MANAGER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SLEEP_MAX_SITES 8
+
+// State kept in RTC slow memory across deep sleep
+typedef struct {
+    uint32_t magic;                         // SLEEP_STATE_MAGIC when valid
+    int32_t site_index;                     // Site on screen
+    int32_t last_fetch_dt[SLEEP_MAX_SITES]; // Newest reading per site
+    int64_t last_refresh;                   // Unix time of last scheduled refresh
+    uint32_t wake_count;                    // Wakes since the last cold boot
+    float temperature;                      // Summary of the site on screen
+    float water_temp;
+    float pressure;
+} sleep_state_t;
+
+extern sleep_state_t g_sleep_state;
+
+/**
+ * @brief Check whether g_sleep_state survived from before a deep sleep
+ * @return true if the RTC state is valid
+ */
+bool sleep_state_valid(void);
+
+/**
+ * @brief Clear the RTC state and mark it valid
+ */
+void sleep_state_reset(void);
+
+/**
+ * @brief Get the button GPIO that woke the chip from deep sleep
+ * @return GPIO number, or -1 if the wake was not from a button
+ */
+int sleep_wake_gpio(void);
+
+/**
+ * @brief Return the button pins to digital GPIO after a deep sleep wake
+ */
+void sleep_release_wake_pins(void);
+
+/**
+ * @brief Enter deep sleep, waking on the refresh timer or any button
+ * @param sleep_sec Seconds until the timer wake
+ */
+void sleep_enter_deep(uint32_t sleep_sec);
+
+#endif // SLEEP_MANAGER_H
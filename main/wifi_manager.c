@@ -4,16 +4,22 @@
  */
 
 #include <string.h>
+#include <inttypes.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
 #include "esp_system.h"
+#include "esp_attr.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_mac.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 
 #include "wifi_manager.h"
+#include "nvs_storage.h"
 
 static const char* TAG = "wifi_mgr";
 
@@ -24,21 +30,69 @@ static EventGroupHandle_t s_wifi_event_group;
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT      BIT1
 
+#define FULL_CONNECT_TIMEOUT_MS 15000
+
 static int s_retry_num = 0;
+static int s_max_retry = CONFIG_WIFI_MAXIMUM_RETRY;
 static bool s_wifi_initialized = false;
+static bool s_wifi_started = false;
 static int8_t s_wifi_rssi = 0;
+static esp_netif_t* s_sta_netif = NULL;
+
+// Access point of the last good connection, for a directed connect.
+// RTC memory covers deep sleep, NVS covers power loss.
+typedef struct {
+    bool valid;
+    uint8_t bssid[6];
+    uint8_t channel;
+} ap_cache_t;
+
+static RTC_DATA_ATTR ap_cache_t s_ap_cache;
+static ap_cache_t s_connected_ap;  // Filled in on association
+
+#if CONFIG_WIFI_STATIC_IP
+static void set_static_ip(void)
+{
+    esp_netif_dhcpc_stop(s_sta_netif);
+
+    esp_netif_ip_info_t ip_info = {0};
+    ip_info.ip.addr = esp_ip4addr_aton(CONFIG_WIFI_STATIC_IP_ADDR);
+    ip_info.netmask.addr = esp_ip4addr_aton(CONFIG_WIFI_STATIC_NETMASK);
+    ip_info.gw.addr = esp_ip4addr_aton(CONFIG_WIFI_STATIC_GATEWAY);
+    if (esp_netif_set_ip_info(s_sta_netif, &ip_info) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set static IP");
+        return;
+    }
+
+    esp_netif_dns_info_t dns = {0};
+    dns.ip.u_addr.ip4.addr = esp_ip4addr_aton(CONFIG_WIFI_STATIC_DNS);
+    dns.ip.type = ESP_IPADDR_TYPE_V4;
+    esp_netif_set_dns_info(s_sta_netif, ESP_NETIF_DNS_MAIN, &dns);
+}
+#endif
 
 static void event_handler(void* arg, esp_event_base_t event_base,
                           int32_t event_id, void* event_data)
 {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         esp_wifi_connect();
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        wifi_event_sta_connected_t* event = (wifi_event_sta_connected_t*) event_data;
+        memcpy(s_connected_ap.bssid, event->bssid, sizeof(s_connected_ap.bssid));
+        s_connected_ap.channel = event->channel;
+        s_connected_ap.valid = true;
+
+#if CONFIG_WIFI_STATIC_IP
+        // Skip DHCP entirely, GOT_IP follows once the address is set
+        set_static_ip();
+#endif
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        if (s_retry_num < CONFIG_WIFI_MAXIMUM_RETRY) {
+        xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+        if (s_retry_num < s_max_retry) {
             esp_wifi_connect();
             s_retry_num++;
             ESP_LOGI(TAG, "Retry connecting to WiFi... (%d/%d)",
-                     s_retry_num, CONFIG_WIFI_MAXIMUM_RETRY);
+                     s_retry_num, s_max_retry);
         } else {
             xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
             ESP_LOGE(TAG, "WiFi connection failed");
@@ -69,7 +123,7 @@ esp_err_t wifi_init(void)
 
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
+    s_sta_netif = esp_netif_create_default_wifi_sta();
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -82,6 +136,14 @@ esp_err_t wifi_init(void)
     ESP_ERROR_CHECK(esp_event_handler_instance_register(
         IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL, &instance_got_ip));
 
+#if CONFIG_WIFI_FAST_RECONNECT
+    // After a power cycle the RTC copy is gone, fall back to NVS
+    if (!s_ap_cache.valid &&
+        nvs_load_wifi_ap(s_ap_cache.bssid, &s_ap_cache.channel) == ESP_OK) {
+        s_ap_cache.valid = true;
+    }
+#endif
+
     wifi_config_t wifi_config = {
         .sta = {
             .ssid = CONFIG_WIFI_SSID,
@@ -100,58 +162,148 @@ esp_err_t wifi_init(void)
     return ESP_OK;
 }
 
-esp_err_t wifi_connect(void)
+// Connect with the current config and wait for an IP or failure
+static esp_err_t connect_and_wait(bool directed, int timeout_ms)
 {
-    if (!s_wifi_initialized) {
-        esp_err_t ret = wifi_init();
-        if (ret != ESP_OK) {
-            return ret;
-        }
+    wifi_config_t wifi_config;
+    esp_wifi_get_config(WIFI_IF_STA, &wifi_config);
+
+    if (directed) {
+        // Join the known AP on its channel without a full scan
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, s_ap_cache.bssid, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.channel = s_ap_cache.channel;
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        wifi_config.sta.bssid_set = false;
+        wifi_config.sta.channel = 0;
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
     }
+    esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
 
-    // Reset retry counter and clear event bits
+    // A directed connect gives up on the first failure and lets the scan retry
     s_retry_num = 0;
+    s_max_retry = directed ? 0 : CONFIG_WIFI_MAXIMUM_RETRY;
+    s_connected_ap.valid = false;
     xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT);
 
-    ESP_LOGI(TAG, "Connecting to %s...", CONFIG_WIFI_SSID);
-
-    // Check if WiFi is already started, stop it first to reset state
-    wifi_mode_t mode;
-    if (esp_wifi_get_mode(&mode) == ESP_OK) {
-        ESP_LOGI(TAG, "WiFi already started, restarting...");
-        esp_wifi_stop();
-        vTaskDelay(pdMS_TO_TICKS(100));  // Brief delay for WiFi to fully stop
+    // Starting the driver connects from the STA_START event
+    if (!s_wifi_started) {
+        ESP_ERROR_CHECK(esp_wifi_start());
+        s_wifi_started = true;
+    } else {
+        esp_wifi_connect();
     }
 
-    ESP_ERROR_CHECK(esp_wifi_start());
-
     // Wait for connection or failure
     EventBits_t bits = xEventGroupWaitBits(
         s_wifi_event_group,
         WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
         pdFALSE,
         pdFALSE,
-        pdMS_TO_TICKS(15000)  // 15 second timeout
+        pdMS_TO_TICKS(timeout_ms)
     );
 
     if (bits & WIFI_CONNECTED_BIT) {
         return ESP_OK;
     } else if (bits & WIFI_FAIL_BIT) {
         return ESP_FAIL;
-    } else {
+    }
+
+    // Abort the attempt and let its disconnect event land before retrying
+    s_retry_num = s_max_retry;
+    esp_wifi_disconnect();
+    xEventGroupWaitBits(s_wifi_event_group, WIFI_FAIL_BIT, pdFALSE, pdFALSE,
+                        pdMS_TO_TICKS(500));
+    return ESP_ERR_TIMEOUT;
+}
+
+#if CONFIG_WIFI_FAST_RECONNECT
+static void save_connected_ap(void)
+{
+    if (!s_connected_ap.valid) {
+        return;
+    }
+
+    bool changed = !s_ap_cache.valid ||
+                   s_ap_cache.channel != s_connected_ap.channel ||
+                   memcmp(s_ap_cache.bssid, s_connected_ap.bssid, sizeof(s_ap_cache.bssid)) != 0;
+    s_ap_cache = s_connected_ap;
+
+    // Only touch flash when the AP actually changed
+    if (changed) {
+        ESP_LOGI(TAG, "Caching AP " MACSTR " on channel %d",
+                 MAC2STR(s_ap_cache.bssid), s_ap_cache.channel);
+        nvs_save_wifi_ap(s_ap_cache.bssid, s_ap_cache.channel);
+    }
+}
+#endif
+
+esp_err_t wifi_connect(void)
+{
+    if (!s_wifi_initialized) {
+        esp_err_t ret = wifi_init();
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    if (wifi_is_connected()) {
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Connecting to %s...", CONFIG_WIFI_SSID);
+    int64_t start_time = esp_timer_get_time();
+    esp_err_t ret = ESP_FAIL;
+    bool directed = false;
+
+#if CONFIG_WIFI_FAST_RECONNECT
+    if (s_ap_cache.valid) {
+        directed = true;
+        ret = connect_and_wait(true, CONFIG_WIFI_FAST_CONNECT_TIMEOUT_MS);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Fast connect to " MACSTR " failed, scanning",
+                     MAC2STR(s_ap_cache.bssid));
+            s_ap_cache.valid = false;
+            directed = false;
+        }
+    }
+#endif
+
+    if (ret != ESP_OK) {
+        ret = connect_and_wait(false, FULL_CONNECT_TIMEOUT_MS);
+    }
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Connected (%s) in %" PRId64 " ms", directed ? "fast" : "scan",
+                 (esp_timer_get_time() - start_time) / 1000);
+#if CONFIG_WIFI_FAST_RECONNECT
+        save_connected_ap();
+#endif
+    } else if (ret == ESP_ERR_TIMEOUT) {
         ESP_LOGE(TAG, "Connection timeout");
-        return ESP_ERR_TIMEOUT;
     }
+
+    return ret;
 }
 
 void wifi_disconnect(void)
 {
+    s_retry_num = s_max_retry;
     esp_wifi_disconnect();
 }
 
 void wifi_stop(void)
 {
+    if (!s_wifi_started) {
+        return;
+    }
+
+    // Stop without retrying from the disconnect event
+    s_retry_num = s_max_retry;
     esp_wifi_stop();
+    s_wifi_started = false;
+    xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
     ESP_LOGI(TAG, "WiFi stopped");
 }
 